@@ -3,14 +3,92 @@
 #include <cstdlib>
 #include <cmath>
 #include <vector>
-#include <list>
 #include <unordered_map>
 #include <unordered_set>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <memory>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <type_traits>
+#include <string_view>
 
-// Cache block structure
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <random>
+
+// Optional trace decompressors (enabled by the Makefile when the headers exist)
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+
+// POSIX file mapping for the trace reader
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Liveness check of the process holding a decoded-index lock
+#include <signal.h>
+
+// SIMD tag comparison (scalar fallback when none of these are available)
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Hot-path phase timers. Built with -DCACHE_SIM_PROFILE (make bench, or make PROFILE=1),
+// PROFILE_SCOPE(phase) charges the time spent in the enclosing scope to phase;
+// otherwise it expands to nothing. Counters are process-wide and not synchronized,
+// so the breakdown is only meaningful for serial runs.
+enum ProfilePhase { PROFILE_PARSE, PROFILE_SIMULATE, PROFILE_ANALYZE, PROFILE_PHASES };
+
+#ifdef CACHE_SIM_PROFILE
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+inline uint64_t profile_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+inline uint64_t profile_phase_ticks[PROFILE_PHASES] = {};
+
+class ScopedPhaseTimer {
+private:
+    ProfilePhase phase;
+    uint64_t start;
+    
+public:
+    explicit ScopedPhaseTimer(ProfilePhase p) : phase(p), start(profile_ticks()) {}
+    ~ScopedPhaseTimer() { profile_phase_ticks[phase] += profile_ticks() - start; }
+};
+
+#define PROFILE_SCOPE(phase) ScopedPhaseTimer profile_scope_timer(phase)
+#else
+#define PROFILE_SCOPE(phase) ((void)0)
+#endif
+
+// Cache block view (the cache itself stores blocks as structure-of-arrays)
 struct CacheBlock {
     bool valid;
     bool dirty;      // For write-back policy: true if block has been written to
@@ -19,1030 +97,7449 @@ struct CacheBlock {
     CacheBlock() : valid(false), dirty(false), tag(0) {}
 };
 
-// Cache class to hold cache parameters and implement LRU policy
-class Cache {
-private:
-    int block_size;
-    int size;
-    int associativity;
-    int num_sets;
-    int num_blocks;
-    
-    // Cache storage: vector of sets, each set contains blocks
-    std::vector<std::vector<CacheBlock>> cache_sets;
+// Request a cache sends to the level below it, tagged with the trace position
+// that caused it so that independently simulated shards can be merged in order
+struct DownstreamRequest {
+    uint64_t seq;
+    unsigned long address;
+    bool is_write;
+};
+
+// Captures the downstream requests of a set-sharded cache instead of forwarding
+// them, bucketed by the shard that owns the destination set in the next level
+struct DownstreamLog {
+    uint64_t current_seq;            // Trace position of the access being simulated
+    int next_block_size;
+    int next_num_sets;
+    std::vector<std::vector<DownstreamRequest>> buckets;
     
-    // LRU tracking: for each set, maintain a list of block indices in LRU order
-    // Front = most recently used, Back = least recently used
-    std::vector<std::list<int>> lru_lists;
+    DownstreamLog(int block_size, int num_sets, int shards)
+        : current_seq(0), next_block_size(block_size), next_num_sets(num_sets), buckets(shards) {}
     
-    // Pointer to next level in memory hierarchy (L2 cache or nullptr for memory)
-    Cache* next_level;
+    void record(unsigned long address, bool is_write) {
+        size_t set_index = (address / next_block_size) % next_num_sets;
+        buckets[set_index % buckets.size()].push_back({current_seq, address, is_write});
+    }
+};
+
+// Cache storage. Every per-set and per-way array of a cache (tags, bitmaps,
+// replacement state) is a FlatArray slice of one cache-line-aligned block, so a cache
+// costs a single allocation however many sets it has. StorageLayout places the
+// arrays: run once without a base to measure the block, then over it to bind them.
+static constexpr size_t STORAGE_ALIGNMENT = 64;
+
+struct AlignedFree {
+    void operator()(unsigned char* p) const { std::free(p); }
+};
+using AlignedStorage = std::unique_ptr<unsigned char, AlignedFree>;
+
+inline AlignedStorage allocate_aligned_storage(size_t bytes) {
+    size_t rounded = (bytes + STORAGE_ALIGNMENT - 1) & ~(STORAGE_ALIGNMENT - 1);
+    return AlignedStorage(static_cast<unsigned char*>(std::aligned_alloc(STORAGE_ALIGNMENT, rounded)));
+}
 
+// Non-owning view of count elements inside a cache's storage block
+template <class T>
+class FlatArray {
+    static_assert(std::is_trivially_copyable<T>::value, "cache storage holds plain data only");
+    T* data_;
+    size_t size_;
+    
 public:
-    // Constructor
-    Cache(int bs = 0, int s = 0, int assoc = 0, Cache* next = nullptr) 
-        : block_size(bs), size(s), associativity(assoc), next_level(next) {
-        if (is_enabled()) {
-            num_blocks = size / block_size;
-            num_sets = num_blocks / associativity;
-            initialize_cache();
-        } else {
-            num_blocks = 0;
-            num_sets = 0;
-        }
-    }
+    FlatArray() : data_(nullptr), size_(0) {}
+    FlatArray(T* data, size_t size) : data_(data), size_(size) {}
     
-    // Set next level in memory hierarchy
-    void set_next_level(Cache* next) {
-        next_level = next;
-    }
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    T* begin() { return data_; }
+    T* end() { return data_ + size_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+    void fill(const T& value) { std::fill(data_, data_ + size_, value); }
+};
+
+class StorageLayout {
+private:
+    unsigned char* base;
+    size_t offset;
     
-    // Calculate cache area based on configuration (simplified model)
-    double calculate_area() const {
-        if (!is_enabled()) return 0.0;
-        
-        // Simplified area model based on CACTI-like estimates
-        // Area factors: tag array + data array + control logic
-        
-        // Basic area per bit (nm² per bit, converted to mm²)
-        const double area_per_bit_nm2 = 0.05;  // 45nm technology node
-        const double nm2_to_mm2 = 1e-12;
-        
-        // Calculate tag bits per block
-        int tag_bits = 32 - static_cast<int>(log2(block_size)) - static_cast<int>(log2(num_sets));
-        
-        // Data array area
-        double data_area = num_blocks * block_size * 8 * area_per_bit_nm2 * nm2_to_mm2;
-        
-        // Tag array area (including valid and dirty bits)
-        double tag_area = num_blocks * (tag_bits + 2) * area_per_bit_nm2 * nm2_to_mm2;
-        
-        // Control logic overhead (proportional to associativity)
-        double control_area = 0.1 * (data_area + tag_area) * (1.0 + 0.1 * associativity);
-        
-        return data_area + tag_area + control_area;
-    }
+public:
+    explicit StorageLayout(unsigned char* b = nullptr) : base(b), offset(0) {}
     
-    // Set timing parameters for AAT calculations
-    void set_timing_parameters(int hit_cycles, int miss_penalty_cycles) {
-        stats.hit_time = hit_cycles;
-        stats.miss_penalty = miss_penalty_cycles;
-        stats.area_mm2 = calculate_area();
+    // Each array starts on its own cache line, so a set never straddles two arrays' lines
+    template <class T>
+    void place(FlatArray<T>& array, size_t count) {
+        offset = (offset + STORAGE_ALIGNMENT - 1) & ~(STORAGE_ALIGNMENT - 1);
+        array = FlatArray<T>(base ? reinterpret_cast<T*>(base + offset) : nullptr, count);
+        offset += count * sizeof(T);
     }
     
-    // Getter methods
-    int get_block_size() const { return block_size; }
-    int get_size() const { return size; }
-    int get_associativity() const { return associativity; }
-    int get_num_sets() const { return num_sets; }
-    int get_num_blocks() const { return num_blocks; }
+    size_t bytes() const { return offset; }
+};
+
+// Bump allocator shared by the caches of a sweep, so hundreds of configurations
+// draw from a few large chunks. Memory is only returned when the arena is destroyed;
+// reset() rewinds it once every cache using it is gone, keeping the chunks.
+class StorageArena {
+private:
+    struct Chunk {
+        AlignedStorage data;
+        size_t size;
+        size_t used;
+    };
+    size_t chunk_bytes;
+    std::vector<Chunk> chunks;
+    size_t current;   // First chunk that may still have room
     
-    // Setter methods
-    void set_block_size(int bs) { 
-        block_size = bs; 
-        recalculate_parameters();
-    }
-    void set_size(int s) { 
-        size = s; 
-        recalculate_parameters();
-    }
-    void set_associativity(int assoc) { 
-        associativity = assoc; 
-        recalculate_parameters();
-    }
+public:
+    explicit StorageArena(size_t chunk = size_t(64) << 20) : chunk_bytes(chunk), current(0) {}
     
-    // Check if cache is enabled
-    bool is_enabled() const {
-        return size > 0;
-    }
+    StorageArena(const StorageArena&) = delete;
+    StorageArena& operator=(const StorageArena&) = delete;
     
-    // Cache access methods
-    bool access(unsigned long address, bool is_write = false) {
-        if (!is_enabled()) return false;
-        
-        unsigned long block_addr = address / block_size;
-        int set_index = block_addr % num_sets;
-        unsigned long tag = block_addr / num_sets;
-        
-        // Check if tag exists in the set (HIT case)
-        for (int i = 0; i < associativity; i++) {
-            if (cache_sets[set_index][i].valid && 
-                cache_sets[set_index][i].tag == tag) {
-                
-                // HIT: Update LRU order (move to most recently used)
-                update_lru(set_index, i);
-                
-                // For write hits, mark block as dirty (write-back policy)
-                if (is_write) {
-                    cache_sets[set_index][i].dirty = true;
-                }
-                
-                // Block remains valid (already was valid for a hit)
-                // cache_sets[set_index][i].valid = true; // Already true
-                
-                return true; // HIT
+    // STORAGE_ALIGNMENT-aligned block of bytes, or nullptr when out of memory
+    unsigned char* allocate(size_t bytes) {
+        bytes = (bytes + STORAGE_ALIGNMENT - 1) & ~(STORAGE_ALIGNMENT - 1);
+        for (; current < chunks.size(); current++) {
+            Chunk& chunk = chunks[current];
+            if (chunk.size - chunk.used >= bytes) {
+                unsigned char* p = chunk.data.get() + chunk.used;
+                chunk.used += bytes;
+                return p;
             }
         }
-        
-        // MISS: Need to insert the block (write-allocate for both reads and writes)
-        insert_block(set_index, tag, is_write);
-        return false; // MISS
+        size_t size = std::max(chunk_bytes, bytes);
+        AlignedStorage data = allocate_aligned_storage(size);
+        if (!data) return nullptr;
+        unsigned char* p = data.get();
+        chunks.push_back({std::move(data), size, bytes});
+        current = chunks.size() - 1;
+        return p;
     }
     
-    // Insert a new block using LRU replacement with proper two-step allocation
-    void insert_block(int set_index, unsigned long tag, bool is_write = false) {
-        int victim_way = get_lru_victim(set_index);
-        
-        // STEP 1: Make space for the requested block
-        if (cache_sets[set_index][victim_way].valid) {
-            // All blocks in set are valid, need to evict victim
-            if (cache_sets[set_index][victim_way].dirty) {
-                // Victim is dirty - must writeback to next level
-                unsigned long victim_block_addr = cache_sets[set_index][victim_way].tag * num_sets + set_index;
-                unsigned long victim_address = victim_block_addr * block_size;
-                
-                // Issue write request to next level
-                if (next_level != nullptr) {
-                    next_level->access(victim_address, true);
-                } else {
-                    // Write to main memory (no action needed in simulation)
-                    handle_memory_write(victim_address);
-                }
-            }
-            // Clear the victim block's state (it's being evicted)
-            cache_sets[set_index][victim_way].valid = false;
-            cache_sets[set_index][victim_way].dirty = false;
-            cache_sets[set_index][victim_way].tag = 0;
-        }
-        
-        // STEP 2: Bring in the requested block
-        // Calculate original address from tag and set
-        unsigned long requested_block_addr = tag * num_sets + set_index;
-        unsigned long requested_address = requested_block_addr * block_size;
-        
-        // Issue read request to next level to bring in the block
-        if (next_level != nullptr) {
-            next_level->access(requested_address, false);
-        } else {
-            // Read from main memory (no action needed in simulation)
-            handle_memory_read(requested_address);
+    void reset() {
+        for (Chunk& chunk : chunks) {
+            chunk.used = 0;
         }
-        
-        // STEP 3: Install the new block and update all state
-        cache_sets[set_index][victim_way].valid = true;        // Mark as valid
-        cache_sets[set_index][victim_way].tag = tag;           // Set the tag
-        cache_sets[set_index][victim_way].dirty = is_write;    // Mark dirty only if it's a write
-        
-        // STEP 4: Update LRU order (move newly installed block to most recently used)
-        update_lru(set_index, victim_way);
+        current = 0;
     }
     
-    // Handle memory operations (placeholder for actual memory interface)
-    void handle_memory_write(unsigned long address) {
-        // In a real implementation, this would interface with main memory
-        // For simulation purposes, we just acknowledge the write
-        stats.writebacks++;  // Count writebacks to memory
+    size_t reserved_bytes() const {
+        size_t total = 0;
+        for (const Chunk& chunk : chunks) {
+            total += chunk.size;
+        }
+        return total;
     }
+};
+
+// Replacement policies. CacheT is instantiated on one of these, so every call below
+// resolves at compile time. Each policy keeps its state in flat per-set arrays and
+// provides:
+//   layout(storage, sets, assoc)    place the state arrays in the cache's storage block
+//   init()                          reset all state
+//   on_hit(set, way)                demand hit on way
+//   on_fill(set, way)               block installed in way
+//   victim(set)                     way to evict from a full set
+//   order(set, ways)                ways in eviction-priority order, kept blocks first (printing)
+//   copy_set(other, set)            adopt one set's state from an identical cache
+//   validate()                      internal consistency check
+// SET_LOCAL says each set's state evolves independently of other sets (shardable);
+// NEEDS_FUTURE says the simulator must supply the next use of every access (OPT).
+
+// True LRU: a doubly-linked recency list of way indices per set, stored in flat arrays
+// (entry set * associativity + way), so no per-node allocation.
+// Head = most recently used, Tail = least recently used
+class LruPolicy {
+private:
+    struct LruLink {
+        int prev;   // Next more recently used way (-1 at head)
+        int next;   // Next less recently used way (-1 at tail)
+    };
+    int associativity;
+    FlatArray<LruLink> lru_links;
+    FlatArray<int> lru_head;
+    FlatArray<int> lru_tail;
     
-    void handle_memory_read(unsigned long address) {
-        // In a real implementation, this would interface with main memory
-        // For simulation purposes, we just acknowledge the read
+    LruLink& lru_link(int set_index, int way) {
+        return lru_links[static_cast<size_t>(set_index) * associativity + way];
     }
     
-    // Handle writeback of dirty block to next level (legacy method)
-    void handle_writeback(int set_index, int way) {
-        // This method is kept for backward compatibility
-        // The new two-step allocation process handles writebacks directly
-        cache_sets[set_index][way].dirty = false;
+    const LruLink& lru_link(int set_index, int way) const {
+        return lru_links[static_cast<size_t>(set_index) * associativity + way];
     }
     
-    // Convenience methods for specific access types
-    bool read(unsigned long address) {
-        return access(address, false);
-    }
+public:
+    static constexpr bool SET_LOCAL = true;
+    static constexpr bool NEEDS_FUTURE = false;
+    static const char* name() { return "lru"; }
     
-    bool write(unsigned long address) {
-        return access(address, true);
+    LruPolicy() : associativity(0) {}
+    
+    void layout(StorageLayout& storage, int num_sets, int assoc) {
+        associativity = assoc;
+        storage.place(lru_links, static_cast<size_t>(num_sets) * associativity);
+        storage.place(lru_head, num_sets);
+        storage.place(lru_tail, num_sets);
     }
     
-    // Get statistics about dirty blocks
-    int get_dirty_blocks_count() const {
-        int count = 0;
+    // Initialize LRU lists with way indices (0 = MRU to associativity-1 = LRU)
+    void init() {
+        int num_sets = static_cast<int>(lru_head.size());
+        lru_head.fill(0);
+        lru_tail.fill(associativity - 1);
         for (int set = 0; set < num_sets; set++) {
             for (int way = 0; way < associativity; way++) {
-                if (cache_sets[set][way].valid && cache_sets[set][way].dirty) {
-                    count++;
-                }
+                LruLink& link = lru_link(set, way);
+                link.prev = way - 1;
+                link.next = (way + 1 < associativity) ? way + 1 : -1;
             }
         }
-        return count;
-    }
-    
-    // Check if this cache has a next level
-    bool has_next_level() const {
-        return next_level != nullptr;
     }
     
-    // Get cache level name for debugging
-    std::string get_level_name() const {
-        if (next_level == nullptr) {
-            return "L2 (or Last Level)";
-        } else if (next_level->has_next_level()) {
-            return "L1";
+    // Move a way to the most recently used position (O(1) unlink and relink)
+    void on_hit(int set_index, int way) {
+        int head = lru_head[set_index];
+        if (head == way) {
+            return; // Already most recently used
+        }
+        
+        // Remove the way from its current position
+        LruLink& link = lru_link(set_index, way);
+        lru_link(set_index, link.prev).next = link.next;
+        if (link.next != -1) {
+            lru_link(set_index, link.next).prev = link.prev;
         } else {
-            return "L1";
+            lru_tail[set_index] = link.prev;
         }
+        
+        // Add it to the front (most recently used)
+        link.prev = -1;
+        link.next = head;
+        lru_link(set_index, head).prev = way;
+        lru_head[set_index] = way;
     }
     
-    // Debug method to check block state
-    void print_block_state(int set_index, int way) const {
-        const auto& block = cache_sets[set_index][way];
-        std::cout << "Block[" << set_index << "][" << way << "]: "
-                  << "Valid=" << (block.valid ? "Y" : "N") << ", "
-                  << "Dirty=" << (block.dirty ? "Y" : "N") << ", "
-                  << "Tag=0x" << std::hex << block.tag << std::dec << std::endl;
+    void on_fill(int set_index, int way) {
+        on_hit(set_index, way);
     }
     
-    // Debug method to print LRU order for a set
-    void print_lru_order(int set_index) const {
-        std::cout << "Set " << set_index << " LRU order (MRU->LRU): ";
-        for (auto way : lru_lists[set_index]) {
-            std::cout << way << " ";
+    // The block at the tail of the LRU list (least recently used)
+    int victim(int set_index) const {
+        return lru_tail[set_index];
+    }
+    
+    // MRU -> LRU
+    void order(int set_index, std::vector<int>& ways) const {
+        ways.clear();
+        for (int way = lru_head[set_index]; way != -1; way = lru_link(set_index, way).next) {
+            ways.push_back(way);
         }
-        std::cout << std::endl;
     }
     
-    // Validate that all state is consistent
-    bool validate_cache_state() const {
-        for (int set = 0; set < num_sets; set++) {
-            // Check LRU list has correct size
-            if (lru_lists[set].size() != associativity) {
-                return false;
-            }
-            
-            // Check all ways are represented in LRU list
+    void copy_set(const LruPolicy& other, int set_index) {
+        size_t first = static_cast<size_t>(set_index) * associativity;
+        std::copy(other.lru_links.begin() + first, other.lru_links.begin() + first + associativity,
+                  lru_links.begin() + first);
+        lru_head[set_index] = other.lru_head[set_index];
+        lru_tail[set_index] = other.lru_tail[set_index];
+    }
+    
+    bool validate() const {
+        for (size_t set = 0; set < lru_head.size(); set++) {
+            // Check all ways are represented in LRU list, walking MRU -> LRU
             std::vector<bool> way_present(associativity, false);
-            for (int way : lru_lists[set]) {
+            int length = 0;
+            int prev = -1;
+            for (int way = lru_head[set]; way != -1; way = lru_link(set, way).next) {
                 if (way < 0 || way >= associativity) return false;
                 if (way_present[way]) return false; // Duplicate way
+                if (lru_link(set, way).prev != prev) return false; // Broken back link
                 way_present[way] = true;
+                prev = way;
+                length++;
             }
             
-            // Check all ways are accounted for
-            for (int way = 0; way < associativity; way++) {
-                if (!way_present[way]) return false;
+            // Check LRU list has correct size (so every way is present) and ends at the tail
+            if (length != associativity || lru_tail[set] != prev) {
+                return false;
             }
         }
         return true;
     }
+};
+
+// Tree pseudo-LRU: leaves - 1 direction bits per set in heap order (node 1 is the
+// root, children 2n and 2n + 1), where leaves is associativity rounded up to a power
+// of two. A bit names the subtree holding the next victim. With a non-power-of-two
+// associativity the padding leaves never exist, so the victim walk never descends
+// into a right subtree that holds only padding.
+class PlruPolicy {
+private:
+    int associativity;
+    int leaves;
+    FlatArray<uint8_t> nodes;   // set * leaves + node, node in [1, leaves)
     
-    // Get cache statistics
-    struct CacheStats {
-        unsigned long reads;
-        unsigned long writes;
-        unsigned long read_hits;
-        unsigned long write_hits;
-        unsigned long read_misses;
-        unsigned long write_misses;
-        unsigned long writebacks;
-        
-        // AAT (Average Access Time) parameters
-        int hit_time;           // Cache hit time in cycles
-        int miss_penalty;       // Miss penalty in cycles
-        double area_mm2;        // Cache area in mm²
-        
-        CacheStats() : reads(0), writes(0), read_hits(0), write_hits(0), 
-                       read_misses(0), write_misses(0), writebacks(0),
-                       hit_time(1), miss_penalty(100), area_mm2(0.0) {}
-                       
-        double get_read_miss_rate() const {
-            return reads > 0 ? (double)read_misses / reads : 0.0;
+public:
+    static constexpr bool SET_LOCAL = true;
+    static constexpr bool NEEDS_FUTURE = false;
+    static const char* name() { return "plru"; }
+    
+    PlruPolicy() : associativity(0), leaves(0) {}
+    
+    void layout(StorageLayout& storage, int num_sets, int assoc) {
+        associativity = assoc;
+        leaves = 1;
+        while (leaves < assoc) {
+            leaves <<= 1;
         }
-        
-        double get_write_miss_rate() const {
-            return writes > 0 ? (double)write_misses / writes : 0.0;
+        storage.place(nodes, static_cast<size_t>(num_sets) * leaves);
+    }
+    
+    void init() {
+        nodes.fill(0);
+    }
+    
+    // Point every node on the way's path at the other subtree
+    void on_hit(int set_index, int way) {
+        uint8_t* tree = &nodes[static_cast<size_t>(set_index) * leaves];
+        for (int node = way + leaves; node > 1; node >>= 1) {
+            tree[node >> 1] = (node & 1) ? 0 : 1;
         }
-        
-        double get_overall_miss_rate() const {
-            unsigned long total = reads + writes;
-            unsigned long total_misses = read_misses + write_misses;
-            return total > 0 ? (double)total_misses / total : 0.0;
+    }
+    
+    void on_fill(int set_index, int way) {
+        on_hit(set_index, way);
+    }
+    
+    // A node covering span leaves starts at leaf node * span - leaves
+    int victim(int set_index) const {
+        const uint8_t* tree = &nodes[static_cast<size_t>(set_index) * leaves];
+        int node = 1;
+        for (int span = leaves >> 1; span > 0; span >>= 1) {
+            int child = 2 * node + tree[node];
+            node = child * span - leaves < associativity ? child : 2 * node;
         }
-        
-        // Calculate Average Access Time (AAT)
-        double get_aat() const {
-            double miss_rate = get_overall_miss_rate();
-            return hit_time + (miss_rate * miss_penalty);
+        return node - leaves;
+    }
+    
+    void order(int set_index, std::vector<int>& ways) const {
+        (void)set_index;
+        ways.clear();
+        for (int way = 0; way < associativity; way++) {
+            ways.push_back(way);
         }
-        
-        // Calculate effective access time including write considerations
-        double get_effective_aat() const {
-            if (reads + writes == 0) return 0.0;
-            
-            double read_miss_rate = get_read_miss_rate();
-            double write_miss_rate = get_write_miss_rate();
-            double read_ratio = (double)reads / (reads + writes);
-            double write_ratio = (double)writes / (reads + writes);
-            
-            // Weighted AAT considering read/write mix
-            double read_aat = hit_time + (read_miss_rate * miss_penalty);
-            double write_aat = hit_time + (write_miss_rate * miss_penalty);
-            
-            return (read_ratio * read_aat) + (write_ratio * write_aat);
+    }
+    
+    void copy_set(const PlruPolicy& other, int set_index) {
+        size_t first = static_cast<size_t>(set_index) * leaves;
+        std::copy(other.nodes.begin() + first, other.nodes.begin() + first + leaves, nodes.begin() + first);
+    }
+    
+    bool validate() const {
+        return true;
+    }
+};
+
+// FIFO: a per-set round-robin pointer at the oldest way. Invalid ways are filled
+// lowest first, so the pointer follows insertion order from the first fill.
+class FifoPolicy {
+private:
+    int associativity;
+    FlatArray<int> oldest;
+    
+public:
+    static constexpr bool SET_LOCAL = true;
+    static constexpr bool NEEDS_FUTURE = false;
+    static const char* name() { return "fifo"; }
+    
+    FifoPolicy() : associativity(0) {}
+    
+    void layout(StorageLayout& storage, int num_sets, int assoc) {
+        associativity = assoc;
+        storage.place(oldest, num_sets);
+    }
+    
+    void init() {
+        oldest.fill(0);
+    }
+    
+    void on_hit(int, int) {}
+    
+    void on_fill(int set_index, int way) {
+        if (way == oldest[set_index]) {
+            oldest[set_index] = (way + 1 == associativity) ? 0 : way + 1;
         }
-        
-        // Performance per area metric
-        double get_performance_per_area() const {
-            if (area_mm2 <= 0.0) return 0.0;
-            double aat = get_aat();
-            return aat > 0.0 ? (1.0 / aat) / area_mm2 : 0.0;
+    }
+    
+    int victim(int set_index) const {
+        return oldest[set_index];
+    }
+    
+    // Newest -> oldest
+    void order(int set_index, std::vector<int>& ways) const {
+        ways.clear();
+        for (int i = 1; i <= associativity; i++) {
+            ways.push_back((oldest[set_index] - i + associativity) % associativity);
         }
-    };
+    }
     
-    // Statistics tracking
-    mutable CacheStats stats;
+    void copy_set(const FifoPolicy& other, int set_index) {
+        oldest[set_index] = other.oldest[set_index];
+    }
     
-    // Print cache contents (blocks from MRU to LRU, only valid blocks)
-    void print_cache_contents(const std::string& cache_name) const {
-        std::cout << "===== " << cache_name << " contents =====" << std::endl;
-        
-        bool has_valid_blocks = false;
-        
-        for (int set = 0; set < num_sets; set++) {
-            std::vector<std::pair<int, const CacheBlock*>> valid_blocks;
-            
-            // Collect valid blocks in LRU order (MRU first)
-            for (int way : lru_lists[set]) {
-                if (cache_sets[set][way].valid) {
-                    valid_blocks.push_back({way, &cache_sets[set][way]});
-                }
-            }
-            
-            // Only print set if it has valid blocks
-            if (!valid_blocks.empty()) {
-                std::cout << "Set " << std::setfill(' ') << std::setw(3) << set << ":";
-                
-                for (const auto& block_pair : valid_blocks) {
-                    const CacheBlock* block = block_pair.second;
-                    std::cout << " " << std::hex << std::setfill('0') << std::setw(8) << block->tag;
-                    if (block->dirty) {
-                        std::cout << " D";
-                    }
-                }
-                std::cout << std::dec << std::endl;
-                has_valid_blocks = true;
-            }
+    bool validate() const {
+        for (int way : oldest) {
+            if (way < 0 || way >= associativity) return false;
         }
-        
-        if (!has_valid_blocks) {
-            std::cout << "Empty" << std::endl;
+        return true;
+    }
+};
+
+// Random: a per-set xorshift32 generator, so results are reproducible and each set's
+// choices do not depend on accesses to other sets
+class RandomPolicy {
+private:
+    int associativity;
+    FlatArray<uint32_t> state;
+    
+public:
+    static constexpr bool SET_LOCAL = true;
+    static constexpr bool NEEDS_FUTURE = false;
+    static const char* name() { return "random"; }
+    
+    RandomPolicy() : associativity(0) {}
+    
+    void layout(StorageLayout& storage, int num_sets, int assoc) {
+        associativity = assoc;
+        storage.place(state, num_sets);
+    }
+    
+    void init() {
+        for (size_t set = 0; set < state.size(); set++) {
+            state[set] = 0x9e3779b9u ^ (static_cast<uint32_t>(set) * 0x85ebca6bu);
+            if (state[set] == 0) state[set] = 1;
         }
-        
-        std::cout << std::endl;
     }
     
-    // Access with statistics tracking
-    bool access_with_stats(unsigned long address, bool is_write = false) {
-        bool hit = access(address, is_write);
-        
-        // Update statistics
-        if (is_write) {
-            stats.writes++;
-            if (hit) {
-                stats.write_hits++;
-            } else {
-                stats.write_misses++;
-            }
-        } else {
-            stats.reads++;
-            if (hit) {
-                stats.read_hits++;
-            } else {
-                stats.read_misses++;
-            }
+    void on_hit(int, int) {}
+    void on_fill(int, int) {}
+    
+    int victim(int set_index) {
+        uint32_t x = state[set_index];
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        state[set_index] = x;
+        return static_cast<int>(x % static_cast<uint32_t>(associativity));
+    }
+    
+    void order(int set_index, std::vector<int>& ways) const {
+        (void)set_index;
+        ways.clear();
+        for (int way = 0; way < associativity; way++) {
+            ways.push_back(way);
         }
-        
-        return hit;
     }
     
-    // Get statistics
-    const CacheStats& get_stats() const {
-        return stats;
+    void copy_set(const RandomPolicy& other, int set_index) {
+        state[set_index] = other.state[set_index];
     }
     
-    // Reset statistics
-    void reset_stats() {
-        stats = CacheStats();
+    bool validate() const {
+        return true;
     }
+};
+
+// Re-reference interval prediction with 2-bit RRPVs (Jaleel et al.). Hits reset the
+// RRPV to 0 and the victim is the first way at the maximum RRPV, ageing the set until
+// one exists. SRRIP inserts at long re-reference (max - 1); BRRIP inserts at distant
+// re-reference (max) except for one fill in BRRIP_EPSILON, counted per set.
+template <bool Bimodal>
+class RripPolicy {
+private:
+    static constexpr uint8_t RRPV_MAX = 3;
+    static constexpr int BRRIP_EPSILON = 32;
     
-    // Get LRU victim (least recently used block)
-    int get_lru_victim(int set_index) {
-        // Return the block at the back of the LRU list (least recently used)
-        return lru_lists[set_index].back();
+    int associativity;
+    FlatArray<uint8_t> rrpv;          // set * associativity + way
+    FlatArray<uint8_t> fill_count;    // BRRIP throttle, per set
+    
+public:
+    static constexpr bool SET_LOCAL = true;
+    static constexpr bool NEEDS_FUTURE = false;
+    static const char* name() { return Bimodal ? "brrip" : "srrip"; }
+    
+    RripPolicy() : associativity(0) {}
+    
+    void layout(StorageLayout& storage, int num_sets, int assoc) {
+        associativity = assoc;
+        storage.place(rrpv, static_cast<size_t>(num_sets) * associativity);
+        storage.place(fill_count, Bimodal ? num_sets : 0);
     }
     
-    // Update LRU order when a block is accessed
-    void update_lru(int set_index, int way) {
-        auto& lru_list = lru_lists[set_index];
-        
-        // Remove the way from its current position
-        lru_list.remove(way);
-        
-        // Add it to the front (most recently used)
-        lru_list.push_front(way);
+    void init() {
+        rrpv.fill(RRPV_MAX);
+        fill_count.fill(0);
     }
     
-    // Validate cache configuration according to requirements
-    bool is_valid_configuration() const {
-        if (!is_enabled()) return true; // Disabled cache is valid
-        
-        // Check if block size is power of 2
-        if (!is_power_of_two(block_size)) {
-            return false;
-        }
-        
-        // Check if number of sets is power of 2
-        if (!is_power_of_two(num_sets)) {
-            return false;
-        }
-        
-        // Check basic constraints
-        if (block_size <= 0 || size <= 0 || associativity <= 0) {
-            return false;
-        }
-        
-        // Check if associativity doesn't exceed total blocks
-        if (associativity > num_blocks) {
-            return false;
-        }
-        
-        // Check if size is divisible by block_size
-        if (size % block_size != 0) {
-            return false;
-        }
-        
-        // Check if num_blocks is divisible by associativity
-        if (num_blocks % associativity != 0) {
-            return false;
-        }
-        
-        return true;
+    void on_hit(int set_index, int way) {
+        rrpv[static_cast<size_t>(set_index) * associativity + way] = 0;
     }
     
-    // Get configuration error message
-    std::string get_config_error() const {
-        if (!is_enabled()) return "";
-        
-        if (block_size <= 0) return "Block size must be positive";
-        if (size <= 0) return "Cache size must be positive";
-        if (associativity <= 0) return "Associativity must be positive";
-        
-        if (!is_power_of_two(block_size)) {
-            return "Block size must be a power of 2";
+    void on_fill(int set_index, int way) {
+        uint8_t value = RRPV_MAX - 1;
+        if (Bimodal) {
+            uint8_t& count = fill_count[set_index];
+            value = (count == 0) ? RRPV_MAX - 1 : RRPV_MAX;
+            count = (count + 1) % BRRIP_EPSILON;
         }
-        
-        if (size % block_size != 0) {
-            return "Cache size must be divisible by block size";
+        rrpv[static_cast<size_t>(set_index) * associativity + way] = value;
+    }
+    
+    int victim(int set_index) {
+        uint8_t* set_rrpv = &rrpv[static_cast<size_t>(set_index) * associativity];
+        uint8_t oldest = *std::max_element(set_rrpv, set_rrpv + associativity);
+        if (oldest < RRPV_MAX) {
+            for (int way = 0; way < associativity; way++) {
+                set_rrpv[way] += RRPV_MAX - oldest;
+            }
         }
-        
-        if (num_blocks % associativity != 0) {
-            return "Number of blocks must be divisible by associativity";
+        return static_cast<int>(std::find(set_rrpv, set_rrpv + associativity, RRPV_MAX) - set_rrpv);
+    }
+    
+    // By predicted re-reference, nearest first
+    void order(int set_index, std::vector<int>& ways) const {
+        const uint8_t* set_rrpv = &rrpv[static_cast<size_t>(set_index) * associativity];
+        ways.clear();
+        for (int way = 0; way < associativity; way++) {
+            ways.push_back(way);
         }
-        
-        if (!is_power_of_two(num_sets)) {
-            return "Number of sets must be a power of 2";
+        std::stable_sort(ways.begin(), ways.end(), [set_rrpv](int a, int b) { return set_rrpv[a] < set_rrpv[b]; });
+    }
+    
+    void copy_set(const RripPolicy& other, int set_index) {
+        size_t first = static_cast<size_t>(set_index) * associativity;
+        std::copy(other.rrpv.begin() + first, other.rrpv.begin() + first + associativity, rrpv.begin() + first);
+        if (Bimodal) {
+            fill_count[set_index] = other.fill_count[set_index];
         }
-        
-        if (associativity > num_blocks) {
-            return "Associativity cannot exceed total number of blocks";
+    }
+    
+    bool validate() const {
+        for (uint8_t value : rrpv) {
+            if (value > RRPV_MAX) return false;
         }
-        
-        return "";
+        return true;
     }
+};
 
+using SrripPolicy = RripPolicy<false>;
+using BrripPolicy = RripPolicy<true>;
+
+// Belady's OPT: evict the block whose next use lies farthest in the future. The
+// simulator passes the next-use position of each access through set_next_use()
+// before issuing it; blocks never used again carry NEVER and are evicted first.
+// Each set keeps an indexed max-heap of its ways keyed on next use, so the victim is
+// the heap root and a hit or fill re-keys one way in O(log associativity).
+class OptPolicy {
 private:
-    // Initialize cache storage and LRU structures
-    void initialize_cache() {
-        // Initialize cache sets
-        cache_sets.clear();
-        cache_sets.resize(num_sets, std::vector<CacheBlock>(associativity));
-        
-        // Initialize LRU lists
-        lru_lists.clear();
-        lru_lists.resize(num_sets);
-        
-        // Initialize LRU lists with way indices (0 to associativity-1)
-        for (int set = 0; set < num_sets; set++) {
-            for (int way = 0; way < associativity; way++) {
-                lru_lists[set].push_back(way);
+    int associativity;
+    FlatArray<uint64_t> next_use;    // set * associativity + way
+    FlatArray<int> heap;             // set * associativity + heap slot -> way
+    FlatArray<int> heap_slot;        // set * associativity + way -> heap slot
+    uint64_t pending_next_use;
+    
+    void swap_slots(size_t base, int a, int b) {
+        std::swap(heap[base + a], heap[base + b]);
+        heap_slot[base + heap[base + a]] = a;
+        heap_slot[base + heap[base + b]] = b;
+    }
+    
+    // Restore heap order around one way whose key changed
+    void rekey(int set_index, int way, uint64_t key) {
+        size_t base = static_cast<size_t>(set_index) * associativity;
+        next_use[base + way] = key;
+        int slot = heap_slot[base + way];
+        while (slot > 0) {
+            int parent = (slot - 1) / 2;
+            if (next_use[base + heap[base + parent]] >= key) break;
+            swap_slots(base, slot, parent);
+            slot = parent;
+        }
+        for (;;) {
+            int largest = slot;
+            int left = 2 * slot + 1;
+            int right = left + 1;
+            if (left < associativity && next_use[base + heap[base + left]] > next_use[base + heap[base + largest]]) {
+                largest = left;
+            }
+            if (right < associativity && next_use[base + heap[base + right]] > next_use[base + heap[base + largest]]) {
+                largest = right;
             }
+            if (largest == slot) break;
+            swap_slots(base, slot, largest);
+            slot = largest;
         }
     }
     
-    // Helper function to check if a number is power of 2
-    bool is_power_of_two(int n) const {
-        return n > 0 && (n & (n - 1)) == 0;
+public:
+    static constexpr bool SET_LOCAL = true;
+    static constexpr bool NEEDS_FUTURE = true;
+    static constexpr uint64_t NEVER = UINT64_MAX;
+    static const char* name() { return "opt"; }
+    
+    OptPolicy() : associativity(0), pending_next_use(NEVER) {}
+    
+    void layout(StorageLayout& storage, int num_sets, int assoc) {
+        associativity = assoc;
+        size_t entries = static_cast<size_t>(num_sets) * associativity;
+        storage.place(next_use, entries);
+        storage.place(heap, entries);
+        storage.place(heap_slot, entries);
     }
     
-    // Recalculate derived parameters when base parameters change
-    void recalculate_parameters() {
-        if (is_enabled()) {
-            num_blocks = size / block_size;
-            num_sets = num_blocks / associativity;
-            initialize_cache();
-        } else {
-            num_blocks = 0;
-            num_sets = 0;
-            cache_sets.clear();
-            lru_lists.clear();
+    void init() {
+        next_use.fill(NEVER);
+        pending_next_use = NEVER;
+        for (size_t i = 0; i < heap.size(); i++) {
+            heap[i] = static_cast<int>(i % associativity);
+            heap_slot[i] = static_cast<int>(i % associativity);
         }
     }
-};
-
-// Trace file processing functions
-struct TraceEntry {
-    char operation;              // 'r' for read, 'w' for write
-    unsigned long address;       // 32-bit hexadecimal address (0x00000000 to 0xFFFFFFFF)
     
-    TraceEntry(char op, unsigned long addr) : operation(op), address(addr) {}
+    // Next-use position of the access about to be simulated
+    void set_next_use(uint64_t position) {
+        pending_next_use = position;
+    }
     
-    // Helper to format address as 8-digit hex (showing leading zeros)
-    std::string get_formatted_address() const {
-        std::ostringstream oss;
-        oss << std::hex << std::setfill('0') << std::setw(8) << address;
-        return oss.str();
+    void on_hit(int set_index, int way) {
+        rekey(set_index, way, pending_next_use);
     }
-};
-
-// Parse a single line from trace file
-bool parse_trace_line(const std::string& line, TraceEntry& entry) {
-    std::istringstream iss(line);
-    std::string op_str, addr_str;
     
-    // Read operation and address
-    if (!(iss >> op_str >> addr_str)) {
-        return false; // Invalid format
+    void on_fill(int set_index, int way) {
+        rekey(set_index, way, pending_next_use);
     }
     
-    // Validate operation
-    if (op_str.length() != 1 || (op_str[0] != 'r' && op_str[0] != 'w')) {
-        return false; // Invalid operation
+    int victim(int set_index) const {
+        return heap[static_cast<size_t>(set_index) * associativity];
     }
-    entry.operation = op_str[0];
     
-    // Parse hexadecimal address (32-bit, 8 hex digits)
-    // Leading zeros may be omitted in trace file (e.g., "ffff" = "0000ffff")
-    try {
-        entry.address = std::stoul(addr_str, nullptr, 16);
-        
-        // Validate that address fits in 32 bits
-        if (entry.address > 0xFFFFFFFF) {
-            return false; // Address too large for 32-bit
+    // Nearest next use first
+    void order(int set_index, std::vector<int>& ways) const {
+        const uint64_t* set_next = &next_use[static_cast<size_t>(set_index) * associativity];
+        ways.clear();
+        for (int way = 0; way < associativity; way++) {
+            ways.push_back(way);
         }
-        
-    } catch (const std::exception&) {
-        return false; // Invalid address format
+        std::stable_sort(ways.begin(), ways.end(), [set_next](int a, int b) { return set_next[a] < set_next[b]; });
     }
     
-    return true;
+    void copy_set(const OptPolicy& other, int set_index) {
+        size_t first = static_cast<size_t>(set_index) * associativity;
+        std::copy(other.next_use.begin() + first, other.next_use.begin() + first + associativity,
+                  next_use.begin() + first);
+        std::copy(other.heap.begin() + first, other.heap.begin() + first + associativity, heap.begin() + first);
+        std::copy(other.heap_slot.begin() + first, other.heap_slot.begin() + first + associativity,
+                  heap_slot.begin() + first);
+    }
+    
+    bool validate() const {
+        for (size_t base = 0; base < heap.size(); base += associativity) {
+            for (int slot = 1; slot < associativity; slot++) {
+                if (next_use[base + heap[base + (slot - 1) / 2]] < next_use[base + heap[base + slot]]) return false;
+            }
+        }
+        return true;
+    }
+};
+
+// How a cache relates to the levels above it. NINE (non-inclusive, non-exclusive)
+// fills on every miss and evicts freely. An inclusive level back-invalidates the
+// levels above when it evicts a block, so it always holds a superset of them. An
+// exclusive level is a victim cache: it is filled only with blocks evicted from the
+// level above, and a hit hands the block up and drops it.
+enum class InclusionPolicy { NINE, INCLUSIVE, EXCLUSIVE };
+
+inline const char* inclusion_policy_name(InclusionPolicy inclusion) {
+    switch (inclusion) {
+    case InclusionPolicy::INCLUSIVE: return "inclusive";
+    case InclusionPolicy::EXCLUSIVE: return "exclusive";
+    default: return "nine";
+    }
 }
 
-// Performance Analysis Class for comprehensive cache behavior evaluation
-class PerformanceAnalyzer {
+// Fully associative LRU cache of block addresses, used as a shadow of a real cache:
+// block -> node by linear probing (backward-shift deletion), recency as an intrusive
+// doubly linked list over the node arrays, so an access is O(1) with no allocation
+class FullyAssociativeLru {
 private:
-    struct AccessPattern {
-        std::vector<unsigned long> addresses;
-        std::vector<char> operations;
-        std::vector<double> timestamps;
-        
-        void add_access(unsigned long addr, char op, double time = 0.0) {
-            addresses.push_back(addr);
-            operations.push_back(op);
-            timestamps.push_back(time);
+    std::vector<uint64_t> node_block;
+    std::vector<uint32_t> node_prev;
+    std::vector<uint32_t> node_next;
+    std::vector<uint32_t> slots;           // node + 1, 0 = empty
+    uint32_t capacity;
+    uint32_t used;
+    uint32_t head;                         // Most recently used
+    uint32_t tail;                         // Least recently used
+    
+    static const uint32_t NONE = ~0u;
+    
+    size_t find_slot(uint64_t block) const {
+        size_t mask = slots.size() - 1;
+        size_t slot = block_hash(block) & mask;
+        while (slots[slot] != 0 && node_block[slots[slot] - 1] != block) {
+            slot = (slot + 1) & mask;
         }
-        
-        void clear() {
-            addresses.clear();
-            operations.clear();
-            timestamps.clear();
+        return slot;
+    }
+    
+    void erase_slot(size_t slot) {
+        size_t mask = slots.size() - 1;
+        slots[slot] = 0;
+        for (size_t next = (slot + 1) & mask; slots[next] != 0; next = (next + 1) & mask) {
+            size_t home = block_hash(node_block[slots[next] - 1]) & mask;
+            // Move the entry back unless its home lies in (slot, next]
+            if (((next - home) & mask) >= ((next - slot) & mask)) {
+                slots[slot] = slots[next];
+                slots[next] = 0;
+                slot = next;
+            }
         }
-    };
+    }
     
-    AccessPattern pattern;
+    void unlink(uint32_t node) {
+        (node_prev[node] != NONE ? node_next[node_prev[node]] : head) = node_next[node];
+        (node_next[node] != NONE ? node_prev[node_next[node]] : tail) = node_prev[node];
+    }
+    
+    void push_front(uint32_t node) {
+        node_prev[node] = NONE;
+        node_next[node] = head;
+        (head != NONE ? node_prev[head] : tail) = node;
+        head = node;
+    }
     
 public:
-    // Analyze spatial locality in access patterns
-    struct SpatialLocalityStats {
-        double sequential_ratio;        // Ratio of sequential accesses
-        double stride_pattern_ratio;    // Ratio of regular stride patterns
-        double random_access_ratio;     // Ratio of random accesses
-        double avg_stride;              // Average stride distance
-        int max_sequential_length;     // Longest sequential access sequence
-        
-        SpatialLocalityStats() : sequential_ratio(0.0), stride_pattern_ratio(0.0), 
-                               random_access_ratio(0.0), avg_stride(0.0), max_sequential_length(0) {}
-    };
+    static size_t block_hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
     
-    // Analyze temporal locality
-    struct TemporalLocalityStats {
-        double reuse_distance_avg;      // Average reuse distance
-        double hit_rate_temporal;       // Hit rate due to temporal locality
-        int unique_addresses;           // Number of unique addresses accessed
-        double working_set_size;        // Estimated working set size
-        
-        TemporalLocalityStats() : reuse_distance_avg(0.0), hit_rate_temporal(0.0), 
-                                unique_addresses(0), working_set_size(0.0) {}
-    };
+    explicit FullyAssociativeLru(uint32_t blocks)
+        : node_block(blocks), node_prev(blocks), node_next(blocks), capacity(blocks), used(0),
+          head(NONE), tail(NONE) {
+        size_t table = 16;
+        while (table < 2 * static_cast<size_t>(blocks)) table <<= 1;
+        slots.assign(table, 0);
+    }
     
-    // Cache pollution analysis
-    struct PollutionStats {
-        double pollution_rate;          // Rate of cache pollution
-        double useful_data_ratio;       // Ratio of useful vs. polluting data
-        int conflict_misses;            // Estimated conflict misses
-        int capacity_misses;            // Estimated capacity misses
+    uint32_t get_capacity() const { return capacity; }
+    
+    // Access block; true on a hit. A miss inserts it, evicting the LRU block when full.
+    bool access(uint64_t block) {
+        size_t slot = find_slot(block);
+        if (slots[slot] != 0) {
+            uint32_t node = slots[slot] - 1;
+            if (node != head) {
+                unlink(node);
+                push_front(node);
+            }
+            return true;
+        }
         
-        PollutionStats() : pollution_rate(0.0), useful_data_ratio(0.0), 
-                         conflict_misses(0), capacity_misses(0) {}
-    };
+        uint32_t node;
+        if (used < capacity) {
+            node = used++;
+        } else {
+            node = tail;
+            unlink(node);
+            erase_slot(find_slot(node_block[node]));
+            slot = find_slot(block);
+        }
+        node_block[node] = block;
+        slots[slot] = node + 1;
+        push_front(node);
+        return false;
+    }
+};
+
+// Open-addressing hash table from block address to its most recently seen position,
+// two flat arrays with linear probing (memory O(distinct blocks), no per-node allocation).
+// Any 64-bit key is allowed: the one whose key + 1 wraps to the empty marker is kept aside.
+class BlockPositionTable {
+private:
+    std::vector<uint64_t> keys;        // block + 1, 0 = empty slot
+    std::vector<uint64_t> positions;
+    size_t used;
+    bool last_present;                 // Block ~0 (no slot key)
+    uint64_t last_position;
     
-    // Record access pattern for analysis
-    void record_access(unsigned long address, char operation, double timestamp = 0.0) {
-        pattern.add_access(address, operation, timestamp);
+    static const uint64_t LAST_BLOCK = ~uint64_t(0);
+    
+    size_t find_slot(uint64_t key) const {
+        size_t mask = keys.size() - 1;
+        size_t slot = hash(key) & mask;
+        while (keys[slot] != 0 && keys[slot] != key) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
     }
     
-    // Analyze spatial locality
-    SpatialLocalityStats analyze_spatial_locality(int block_size = 32) const {
-        SpatialLocalityStats stats;
-        
-        if (pattern.addresses.size() < 2) return stats;
-        
-        int sequential_count = 0;
-        int stride_count = 0;
-        int max_seq_length = 1;
-        int current_seq_length = 1;
-        long total_stride = 0;
-        
-        // Analyze access patterns
-        for (size_t i = 1; i < pattern.addresses.size(); i++) {
-            long stride = static_cast<long>(pattern.addresses[i]) - static_cast<long>(pattern.addresses[i-1]);
-            total_stride += abs(stride);
-            
-            // Check for sequential access (within same block or next block)
-            if (abs(stride) <= block_size) {
-                sequential_count++;
-                current_seq_length++;
-            } else {
-                max_seq_length = std::max(max_seq_length, current_seq_length);
-                current_seq_length = 1;
-            }
-            
-            // Check for regular stride patterns
-            if (i >= 2) {
-                long prev_stride = static_cast<long>(pattern.addresses[i-1]) - static_cast<long>(pattern.addresses[i-2]);
-                if (stride == prev_stride && stride != 0) {
-                    stride_count++;
-                }
-            }
+    static size_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+    
+    void grow() {
+        std::vector<uint64_t> old_keys(keys.size() * 2, 0);
+        std::vector<uint64_t> old_positions(positions.size() * 2, 0);
+        old_keys.swap(keys);
+        old_positions.swap(positions);
+        size_t mask = keys.size() - 1;
+        for (size_t i = 0; i < old_keys.size(); i++) {
+            if (old_keys[i] == 0) continue;
+            size_t slot = hash(old_keys[i]) & mask;
+            while (keys[slot] != 0) slot = (slot + 1) & mask;
+            keys[slot] = old_keys[i];
+            positions[slot] = old_positions[i];
         }
-        
-        max_seq_length = std::max(max_seq_length, current_seq_length);
-        
-        int total_accesses = pattern.addresses.size() - 1;
-        stats.sequential_ratio = (double)sequential_count / total_accesses;
-        stats.stride_pattern_ratio = (double)stride_count / std::max(total_accesses - 1, 1);
-        stats.random_access_ratio = 1.0 - stats.sequential_ratio - stats.stride_pattern_ratio;
-        stats.avg_stride = (double)total_stride / total_accesses;
-        stats.max_sequential_length = max_seq_length;
-        
-        return stats;
     }
     
-    // Analyze temporal locality
-    TemporalLocalityStats analyze_temporal_locality() const {
-        TemporalLocalityStats stats;
-        
-        if (pattern.addresses.empty()) return stats;
-        
-        std::unordered_map<unsigned long, std::vector<size_t>> address_positions;
-        std::unordered_map<unsigned long, size_t> last_access;
-        
-        // Record positions of each address
-        for (size_t i = 0; i < pattern.addresses.size(); i++) {
-            address_positions[pattern.addresses[i]].push_back(i);
+public:
+    explicit BlockPositionTable(size_t initial_slots = 1 << 16)
+        : keys(initial_slots, 0), positions(initial_slots, 0), used(0), last_present(false), last_position(0) {}
+    
+    // Record block at position; returns its previous position, or missing if unseen
+    uint64_t exchange(uint64_t block, uint64_t position, uint64_t missing) {
+        if (block == LAST_BLOCK) {
+            uint64_t previous = last_present ? last_position : missing;
+            last_present = true;
+            last_position = position;
+            return previous;
         }
-        
-        stats.unique_addresses = address_positions.size();
-        
-        // Calculate reuse distances
-        double total_reuse_distance = 0.0;
-        int reuse_count = 0;
-        
-        for (const auto& addr_positions : address_positions) {
-            const auto& positions = addr_positions.second;
-            for (size_t i = 1; i < positions.size(); i++) {
-                total_reuse_distance += positions[i] - positions[i-1];
-                reuse_count++;
-            }
+        if (2 * (used + 1) > keys.size()) {
+            grow();
         }
-        
-        if (reuse_count > 0) {
-            stats.reuse_distance_avg = total_reuse_distance / reuse_count;
+        uint64_t key = block + 1;
+        size_t slot = find_slot(key);
+        uint64_t previous = missing;
+        if (keys[slot] == key) {
+            previous = positions[slot];
+        } else {
+            keys[slot] = key;
+            used++;
         }
-        
-        // Estimate working set size (unique addresses in recent window)
-        const size_t window_size = std::min((size_t)1000, pattern.addresses.size());
-        std::unordered_set<unsigned long> recent_addresses;
-        
-        for (size_t i = pattern.addresses.size() - window_size; i < pattern.addresses.size(); i++) {
-            recent_addresses.insert(pattern.addresses[i]);
+        positions[slot] = position;
+        return previous;
+    }
+    
+    // Position of block, or missing if unseen
+    uint64_t find(uint64_t block, uint64_t missing) const {
+        if (block == LAST_BLOCK) {
+            return last_present ? last_position : missing;
         }
-        
-        stats.working_set_size = recent_addresses.size();
-        
-        return stats;
+        size_t slot = find_slot(block + 1);
+        return keys[slot] != 0 ? positions[slot] : missing;
     }
     
-    // Analyze cache pollution effects
-    PollutionStats analyze_cache_pollution(const Cache& cache) const {
-        PollutionStats stats;
-        
-        if (pattern.addresses.empty()) return stats;
-        
-        // Simulate cache behavior to identify pollution
-        int block_size = cache.get_block_size();
-        int num_sets = cache.get_num_sets();
-        int associativity = cache.get_associativity();
-        
-        // Simple pollution analysis based on set conflicts
-        std::unordered_map<int, std::vector<unsigned long>> set_accesses;
-        
-        for (unsigned long addr : pattern.addresses) {
-            unsigned long block_addr = addr / block_size;
-            int set_index = block_addr % num_sets;
-            set_accesses[set_index].push_back(block_addr);
+    // Remove block (backward-shift deletion keeps every probe chain intact)
+    void erase(uint64_t block) {
+        if (block == LAST_BLOCK) {
+            last_present = false;
+            return;
         }
-        
-        int total_conflicts = 0;
-        int total_accesses = 0;
-        
-        for (const auto& set_access : set_accesses) {
-            const auto& accesses = set_access.second;
-            total_accesses += accesses.size();
-            
-            // Count potential conflicts (more unique blocks than associativity)
-            std::unordered_set<unsigned long> unique_blocks(accesses.begin(), accesses.end());
-            if (unique_blocks.size() > (size_t)associativity) {
-                total_conflicts += accesses.size() - associativity;
-            }
+        size_t slot = find_slot(block + 1);
+        if (keys[slot] == 0) {
+            return;
         }
-        
-        if (total_accesses > 0) {
-            stats.pollution_rate = (double)total_conflicts / total_accesses;
-            stats.useful_data_ratio = 1.0 - stats.pollution_rate;
+        size_t mask = keys.size() - 1;
+        keys[slot] = 0;
+        used--;
+        for (size_t next = (slot + 1) & mask; keys[next] != 0; next = (next + 1) & mask) {
+            size_t home = hash(keys[next]) & mask;
+            if (((next - home) & mask) >= ((next - slot) & mask)) {
+                keys[slot] = keys[next];
+                positions[slot] = positions[next];
+                keys[next] = 0;
+                slot = next;
+            }
         }
-        
-        stats.conflict_misses = total_conflicts;
-        
-        return stats;
     }
     
-    // Generate comprehensive performance report
-    void generate_performance_report(const Cache& l1_cache, const Cache& l2_cache, 
-                                   const std::string& trace_name) const {
-        
-        std::cout << "\n" << std::string(80, '=') << std::endl;
-        std::cout << "COMPREHENSIVE PERFORMANCE ANALYSIS REPORT" << std::endl;
-        std::cout << std::string(80, '=') << std::endl;
-        std::cout << "Trace: " << trace_name << std::endl;
-        std::cout << "Total Accesses: " << pattern.addresses.size() << std::endl;
-        std::cout << std::endl;
-        
-        // Cache Configuration Analysis
-        std::cout << "CACHE CONFIGURATION ANALYSIS" << std::endl;
-        std::cout << std::string(40, '-') << std::endl;
-        
-        const auto& l1_stats = l1_cache.get_stats();
-        std::cout << "L1 Cache:" << std::endl;
-        std::cout << "  Size: " << l1_cache.get_size() << " bytes" << std::endl;
-        std::cout << "  Associativity: " << l1_cache.get_associativity() << "-way" << std::endl;
-        std::cout << "  Block Size: " << l1_cache.get_block_size() << " bytes" << std::endl;
-        std::cout << "  Area: " << std::fixed << std::setprecision(4) << l1_stats.area_mm2 << " mm²" << std::endl;
-        std::cout << "  AAT: " << std::fixed << std::setprecision(2) << l1_stats.get_aat() << " cycles" << std::endl;
-        std::cout << "  Performance/Area: " << std::scientific << std::setprecision(2) 
-                  << l1_stats.get_performance_per_area() << " (1/cycles)/mm²" << std::endl;
-        
-        if (l2_cache.is_enabled()) {
-            const auto& l2_stats = l2_cache.get_stats();
-            std::cout << "\nL2 Cache:" << std::endl;
-            std::cout << "  Size: " << l2_cache.get_size() << " bytes" << std::endl;
-            std::cout << "  Associativity: " << l2_cache.get_associativity() << "-way" << std::endl;
-            std::cout << "  Area: " << std::fixed << std::setprecision(4) << l2_stats.area_mm2 << " mm²" << std::endl;
-            std::cout << "  AAT: " << std::fixed << std::setprecision(2) << l2_stats.get_aat() << " cycles" << std::endl;
-        }
-        
-        // Spatial Locality Analysis
-        auto spatial_stats = analyze_spatial_locality(l1_cache.get_block_size());
-        std::cout << "\nSPATIAL LOCALITY ANALYSIS" << std::endl;
-        std::cout << std::string(40, '-') << std::endl;
-        std::cout << "Sequential Access Ratio: " << std::fixed << std::setprecision(3) 
-                  << spatial_stats.sequential_ratio << std::endl;
-        std::cout << "Stride Pattern Ratio: " << spatial_stats.stride_pattern_ratio << std::endl;
-        std::cout << "Random Access Ratio: " << spatial_stats.random_access_ratio << std::endl;
-        std::cout << "Average Stride: " << std::fixed << std::setprecision(1) 
-                  << spatial_stats.avg_stride << " bytes" << std::endl;
-        std::cout << "Max Sequential Length: " << spatial_stats.max_sequential_length << " accesses" << std::endl;
-        
-        // Temporal Locality Analysis
-        auto temporal_stats = analyze_temporal_locality();
-        std::cout << "\nTEMPORAL LOCALITY ANALYSIS" << std::endl;
-        std::cout << std::string(40, '-') << std::endl;
-        std::cout << "Unique Addresses: " << temporal_stats.unique_addresses << std::endl;
-        std::cout << "Working Set Size: " << temporal_stats.working_set_size << " addresses" << std::endl;
-        std::cout << "Average Reuse Distance: " << std::fixed << std::setprecision(1) 
-                  << temporal_stats.reuse_distance_avg << " accesses" << std::endl;
-        
-        // Cache Pollution Analysis
-        auto pollution_stats = analyze_cache_pollution(l1_cache);
-        std::cout << "\nCACHE POLLUTION ANALYSIS" << std::endl;
-        std::cout << std::string(40, '-') << std::endl;
-        std::cout << "Pollution Rate: " << std::fixed << std::setprecision(3) 
-                  << pollution_stats.pollution_rate << std::endl;
-        std::cout << "Useful Data Ratio: " << pollution_stats.useful_data_ratio << std::endl;
-        std::cout << "Estimated Conflict Misses: " << pollution_stats.conflict_misses << std::endl;
-        
-        // Performance Trade-offs
-        std::cout << "\nPERFORMANCE TRADE-OFFS" << std::endl;
-        std::cout << std::string(40, '-') << std::endl;
-        std::cout << "Miss Rate vs. Area Trade-off:" << std::endl;
-        std::cout << "  Miss Rate: " << std::fixed << std::setprecision(3) 
-                  << l1_stats.get_overall_miss_rate() << std::endl;
-        std::cout << "  Area Cost: " << l1_stats.area_mm2 << " mm²" << std::endl;
-        std::cout << "  Performance Efficiency: " << std::scientific << std::setprecision(2) 
-                  << (1.0 - l1_stats.get_overall_miss_rate()) / l1_stats.area_mm2 << " hit_rate/mm²" << std::endl;
-        
-        std::cout << std::endl;
+    size_t size() const {
+        return used + last_present;
     }
+};
+
+// Set of every block seen so far (open addressing, block + 1 with 0 = empty)
+class BlockSet {
+private:
+    std::vector<uint64_t> keys;              // block + 1, 0 = empty slot
+    size_t used;
+    bool last_present;                       // Block ~0, whose key would wrap to 0
     
-    // Clear recorded access patterns
-    void clear() {
-        pattern.clear();
+public:
+    BlockSet() : keys(1 << 12, 0), used(0), last_present(false) {}
+    
+    // Add block; true if it was not in the set yet
+    bool insert(uint64_t block) {
+        if (block == ~uint64_t(0)) {
+            bool added = !last_present;
+            last_present = true;
+            return added;
+        }
+        if (2 * (used + 1) > keys.size()) {
+            std::vector<uint64_t> old(keys.size() * 2, 0);
+            old.swap(keys);
+            size_t mask = keys.size() - 1;
+            for (uint64_t key : old) {
+                if (key == 0) continue;
+                size_t slot = FullyAssociativeLru::block_hash(key) & mask;
+                while (keys[slot] != 0) slot = (slot + 1) & mask;
+                keys[slot] = key;
+            }
+        }
+        uint64_t key = block + 1;
+        size_t mask = keys.size() - 1;
+        size_t slot = FullyAssociativeLru::block_hash(key) & mask;
+        while (keys[slot] != 0) {
+            if (keys[slot] == key) return false;
+            slot = (slot + 1) & mask;
+        }
+        keys[slot] = key;
+        used++;
+        return true;
     }
 };
 
-// Process trace file and simulate cache accesses
-bool process_trace_file(const std::string& filename, Cache& l1_cache, Cache& l2_cache, 
-                       PerformanceAnalyzer& analyzer, bool verbose = false) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open trace file '" << filename << "'" << std::endl;
-        return false;
-    }
+// Three-C miss classification (compulsory / capacity / conflict), computed online.
+// A miss is compulsory on the first touch of its block, a capacity miss when a fully
+// associative LRU cache with the same number of blocks also misses, and a conflict
+// miss otherwise. The shadow sees exactly the access stream of the cache it
+// classifies. The first-touch set is consulted only when the shadow misses, since a
+// shadow hit means the block was seen before.
+class MissClassifier {
+private:
+    FullyAssociativeLru shadow;
+    BlockSet seen;
     
-    std::string line;
-    int line_number = 0;
-    unsigned long total_accesses = 0;
+public:
+    enum MissClass { HIT, COMPULSORY, CAPACITY, CONFLICT };
     
-    std::cout << "Processing trace file: " << filename << std::endl;
-    std::cout << "Note: All addresses are 32-bit (8 hex digits). Leading zeros may be omitted in trace file." << std::endl;
+    explicit MissClassifier(uint32_t blocks) : shadow(blocks) {}
     
+    static MissClass classify(bool hit, bool shadow_hit, bool first_touch) {
+        return hit ? HIT : shadow_hit ? CONFLICT : first_touch ? COMPULSORY : CAPACITY;
+    }
+    
+    // Update the shadow with an access of block and classify it (HIT when the cache hit)
+    MissClass access(uint64_t block, bool hit) {
+        bool shadow_hit = shadow.access(block);
+        if (hit) {
+            return HIT;
+        }
+        return classify(false, shadow_hit, !shadow_hit && seen.insert(block));
+    }
+};
+
+// Physical address width assumed for the tag arrays of the area model. Set by
+// --address-bits (accepted by every mode); 32 unless traces use wider addresses.
+inline int area_address_bits = 32;
+
+// Cache class to hold cache parameters; replacement is delegated to Policy
+template <class Policy>
+class CacheT {
+private:
+    int block_size;
+    int size;
+    int associativity;
+    int num_sets;
+    int num_blocks;
+    
+    // Cache storage (structure-of-arrays): one contiguous tag array indexed by
+    // set * associativity + way, plus valid/dirty bitmaps of words_per_set words per set
+    FlatArray<uint64_t> tags;
+    FlatArray<uint64_t> valid_bits;
+    FlatArray<uint64_t> dirty_bits;
+    int words_per_set;
+    unsigned long dirty_blocks;    // Set bits of dirty_bits, kept up to date by every update
+    
+    // The block all of the arrays above, set_fill and the policy state are carved
+    // from: owned, or borrowed from a StorageArena when arena is set
+    StorageArena* arena;
+    AlignedStorage owned_storage;
+    unsigned char* storage;
+    size_t storage_capacity;
+    size_t storage_used;       // Bytes the current geometry uses (at most storage_capacity)
+    
+    // Address decomposition. Valid configurations have power-of-two block size and set
+    // count, so shifts and a mask replace the divisions (pow2_geometry); other
+    // geometries keep the division path.
+    bool pow2_geometry;
+    int offset_bits;
+    int index_bits;
+    unsigned long index_mask;
+    
+    // Replacement state, plus the number of valid ways per set so that empty ways
+    // are filled before the policy is asked for a victim
+    Policy policy;
+    FlatArray<int> set_fill;
+    
+    // Pointer to next level in memory hierarchy (L2 cache or nullptr for memory)
+    CacheT* next_level;
+    
+    // Three-C classification of this level's misses (nullptr unless classify_misses())
+    std::unique_ptr<MissClassifier> classifier;
+    
+    // Level above (nullptr for L1) and this level's inclusion of it
+    CacheT* upper_level;
+    InclusionPolicy inclusion;
+    
+    // When set, requests for the next level are logged here instead (sharded simulation)
+    DownstreamLog* downstream_log;
+    
+    // Stream-buffer prefetcher (last-level cache only). A stream buffer always holds
+    // prefetch_depth consecutive blocks, so each one is a sliding window described by
+    // its first block. stream_index maps every buffered block to (buffer << 32 | holders),
+    // so a lookup is one probe; only a block held by several buffers at once falls back
+    // to comparing it against each buffer to find the most recently used holder.
+    int prefetch_buffers;
+    int prefetch_depth;
+    std::vector<unsigned long> stream_base;      // First block held by each buffer
+    std::vector<uint64_t> stream_last_use;       // 0 = invalid, otherwise LRU timestamp
+    uint64_t stream_clock;
+    BlockPositionTable stream_index;
+
+public:
+    using policy_type = Policy;
+    
+    // Constructor. With an arena the storage comes from it and must not outlive it.
+    CacheT(int bs = 0, int s = 0, int assoc = 0, CacheT* next = nullptr, StorageArena* storage_arena = nullptr)
+        : block_size(bs), size(s), associativity(assoc), words_per_set(0), dirty_blocks(0), arena(storage_arena),
+          storage(nullptr), storage_capacity(0), storage_used(0), pow2_geometry(false),
+          offset_bits(0), index_bits(0), index_mask(0), next_level(next),
+          upper_level(nullptr), inclusion(InclusionPolicy::NINE), downstream_log(nullptr), prefetch_buffers(0), prefetch_depth(0), stream_clock(0), stream_index(1) {
+        if (is_enabled()) {
+            num_blocks = size / block_size;
+            num_sets = num_blocks / associativity;
+            initialize_cache();
+        } else {
+            num_blocks = 0;
+            num_sets = 0;
+        }
+    }
+    
+    // The storage arrays point into this cache's own block
+    CacheT(const CacheT&) = delete;
+    CacheT& operator=(const CacheT&) = delete;
+    
+    // Set next level in memory hierarchy (and make this cache the level above it)
+    void set_next_level(CacheT* next) {
+        next_level = next;
+        if (next != nullptr) {
+            next->upper_level = this;
+        }
+    }
+    
+    void set_inclusion(InclusionPolicy policy_kind) {
+        inclusion = policy_kind;
+    }
+    
+    InclusionPolicy get_inclusion() const {
+        return inclusion;
+    }
+    
+    // Log next-level requests instead of issuing them (nullptr to stop logging)
+    void set_downstream_log(DownstreamLog* log) {
+        downstream_log = log;
+    }
+    
+    // Attach pref_n stream buffers of pref_m blocks each (0 disables prefetching).
+    // Prefetches are read from memory, so this is meant for the last-level cache.
+    void set_prefetcher(int pref_n, int pref_m) {
+        prefetch_buffers = pref_m > 0 ? pref_n : 0;
+        prefetch_depth = pref_m;
+        stream_base.assign(prefetch_buffers, 0);
+        stream_last_use.assign(prefetch_buffers, 0);
+        stream_clock = 0;
+        rebuild_stream_index();
+    }
+    
+    bool has_prefetcher() const {
+        return prefetch_buffers > 0;
+    }
+    
+    int get_prefetch_depth() const {
+        return prefetch_depth;
+    }
+    
+    // Calculate cache area based on configuration (simplified model)
+    double calculate_area() const {
+        if (!is_enabled()) return 0.0;
+        return estimate_area(block_size, num_blocks, num_sets, associativity);
+    }
+    
+    // Area model shared with analytic engines that never instantiate the cache
+    static double estimate_area(int block_size, int num_blocks, int num_sets, int associativity) {
+        // Simplified area model based on CACTI-like estimates
+        // Area factors: tag array + data array + control logic
+        
+        // Basic area per bit (nm² per bit, converted to mm²)
+        const double area_per_bit_nm2 = 0.05;  // 45nm technology node
+        const double nm2_to_mm2 = 1e-12;
+        
+        // Calculate tag bits per block
+        int tag_bits = std::max(0, area_address_bits - static_cast<int>(log2(block_size)) -
+                                       static_cast<int>(log2(num_sets)));
+        
+        // Data array area
+        double data_area = num_blocks * block_size * 8 * area_per_bit_nm2 * nm2_to_mm2;
+        
+        // Tag array area (including valid and dirty bits)
+        double tag_area = num_blocks * (tag_bits + 2) * area_per_bit_nm2 * nm2_to_mm2;
+        
+        // Control logic overhead (proportional to associativity)
+        double control_area = 0.1 * (data_area + tag_area) * (1.0 + 0.1 * associativity);
+        
+        return data_area + tag_area + control_area;
+    }
+    
+    // Set timing parameters for AAT calculations
+    void set_timing_parameters(int hit_cycles, int miss_penalty_cycles) {
+        stats.hit_time = hit_cycles;
+        stats.miss_penalty = miss_penalty_cycles;
+        stats.area_mm2 = calculate_area();
+    }
+    
+    // Getter methods
+    int get_block_size() const { return block_size; }
+    int get_size() const { return size; }
+    int get_associativity() const { return associativity; }
+    int get_num_sets() const { return num_sets; }
+    int get_num_blocks() const { return num_blocks; }
+    
+    // Setter methods
+    void set_block_size(int bs) { 
+        block_size = bs; 
+        recalculate_parameters();
+    }
+    void set_size(int s) { 
+        size = s; 
+        recalculate_parameters();
+    }
+    void set_associativity(int assoc) { 
+        associativity = assoc; 
+        recalculate_parameters();
+    }
+    
+    // Check if cache is enabled
+    bool is_enabled() const {
+        return size > 0;
+    }
+    
+    // Cache access methods
+    bool access(unsigned long address, bool is_write = false) {
+        if (!is_enabled()) return false;
+        
+        unsigned long block_addr = block_of(address);
+        return access_block(block_addr, set_of(block_addr), tag_of(block_addr), is_write);
+    }
+    
+    // Access with the address already decomposed (access_batch computes these up front)
+    bool access_block(unsigned long block_addr, int set_index, unsigned long tag, bool is_write) {
+        bool hit = lookup_and_fill(block_addr, set_index, tag, is_write);
+        if (classifier) {
+            count_miss_class(classifier->access(block_addr, hit));
+        }
+        return hit;
+    }
+    
+    // Count a classification made outside the cache (sweeps share one shadow between
+    // the caches of equal capacity that see the same accesses)
+    void count_miss_class(MissClassifier::MissClass miss_class) {
+        stats.compulsory_misses += miss_class == MissClassifier::COMPULSORY;
+        stats.capacity_misses += miss_class == MissClassifier::CAPACITY;
+        stats.conflict_misses += miss_class == MissClassifier::CONFLICT;
+    }
+    
+    // Classify every later miss as compulsory, capacity or conflict (see MissClassifier)
+    void classify_misses() {
+        if (is_enabled()) {
+            classifier = std::make_unique<MissClassifier>(num_blocks);
+        }
+    }
+    
+    bool classifies_misses() const {
+        return classifier != nullptr;
+    }
+    
+    // Hit/miss resolution and fill of one access
+    bool lookup_and_fill(unsigned long block_addr, int set_index, unsigned long tag, bool is_write) {
+        // Check if tag exists in the set (HIT case); stream buffers are searched alongside
+        int way = find_way(set_index, tag);
+        int stream = prefetch_buffers > 0 ? find_stream(block_addr) : -1;
+        if (way >= 0) {
+            // HIT: Update replacement state (LRU: move to most recently used)
+            update_replacement(set_index, way);
+            
+            // For write hits, mark block as dirty (write-back policy)
+            if (is_write) {
+                set_dirty(set_index, way, true);
+            }
+            
+            // Keep a matching stream buffer in sync with the demand stream
+            if (stream >= 0) {
+                advance_stream(stream, block_addr);
+            }
+            
+            // Block remains valid (already was valid for a hit)
+            return true; // HIT
+        }
+        
+        if (stream >= 0) {
+            // Stream-buffer HIT: the block moves into the cache without a demand fetch
+            insert_block(set_index, tag, is_write, false);
+            advance_stream(stream, block_addr);
+            stats.prefetch_hits++;
+            return true;
+        }
+        
+        // MISS: Need to insert the block (write-allocate for both reads and writes)
+        insert_block(set_index, tag, is_write);
+        if (prefetch_buffers > 0) {
+            allocate_stream(block_addr);
+        }
+        return false; // MISS
+    }
+    
+    // Insert a new block using the replacement policy with proper two-step allocation.
+    // fetch is false when the block is supplied by a stream buffer.
+    void insert_block(int set_index, unsigned long tag, bool is_write = false, bool fetch = true) {
+        int victim_way = get_victim(set_index);
+        
+        // STEP 1: Make space for the requested block
+        if (is_valid(set_index, victim_way)) {
+            // All blocks in set are valid, need to evict victim
+            unsigned long victim_address = address_of(block_tag(set_index, victim_way), set_index);
+            bool victim_dirty = is_dirty(set_index, victim_way);
+            
+            // An inclusive level takes the block from every level above; their newer
+            // data, if any, leaves with it
+            if (inclusion == InclusionPolicy::INCLUSIVE && upper_level != nullptr) {
+                victim_dirty |= upper_level->back_invalidate(victim_address);
+            }
+            if (victim_dirty) {
+                stats.writebacks++;
+            }
+            
+            if (next_level != nullptr && next_level->inclusion == InclusionPolicy::EXCLUSIVE) {
+                // A victim cache below receives every evicted block, clean or dirty
+                next_level->victim_fill(victim_address, victim_dirty);
+            } else if (victim_dirty) {
+                // Victim is dirty - must writeback to next level
+                // Issue write request to next level (it counts the write it receives)
+                if (next_level != nullptr) {
+                    next_level->access_with_stats(victim_address, true);
+                } else if (downstream_log != nullptr) {
+                    downstream_log->record(victim_address, true);
+                } else {
+                    // Write to main memory (no action needed in simulation)
+                    handle_memory_write(victim_address);
+                }
+            }
+            // Clear the victim block's state (it's being evicted)
+            invalidate_way(set_index, victim_way);
+        }
+        
+        // STEP 2: Bring in the requested block (unless already prefetched into a
+        // stream buffer). A block handed up by an exclusive level may arrive dirty.
+        bool dirty = is_write;
+        if (fetch) {
+            dirty |= fetch_from_next(address_of(tag, set_index));
+        }
+        
+        // STEP 3: Install the new block and update all state
+        set_fill[set_index]++;
+        set_valid(set_index, victim_way, true);                // Mark as valid
+        tags[tag_index(set_index, victim_way)] = tag;          // Set the tag
+        set_dirty(set_index, victim_way, dirty);               // Dirty if written or handed up dirty
+        
+        // STEP 4: Update replacement state for the newly installed block
+        policy.on_fill(set_index, victim_way);
+    }
+    
+    // Request a block from the next level (or memory) without installing it here.
+    // Returns true when the block arrives dirty, which only an exclusive level can do.
+    bool fetch_from_next(unsigned long address) {
+        if (next_level != nullptr) {
+            if (next_level->inclusion == InclusionPolicy::EXCLUSIVE) {
+                return next_level->fetch_exclusive(address);
+            }
+            next_level->access_with_stats(address, false);
+        } else if (downstream_log != nullptr) {
+            downstream_log->record(address, false);
+        } else {
+            // Read from main memory (no action needed in simulation)
+            handle_memory_read(address);
+        }
+        return false;
+    }
+    
+    // Exclusive level: serve a fetch from the level above. A hit moves the block up
+    // (returning its dirty bit); a miss is passed down without allocating here.
+    bool fetch_exclusive(unsigned long address) {
+        unsigned long block_addr = block_of(address);
+        int set_index = set_of(block_addr);
+        int way = find_way(set_index, tag_of(block_addr));
+        stats.reads++;
+        if (way < 0) {
+            stats.read_misses++;
+            return fetch_from_next(address);
+        }
+        stats.read_hits++;
+        bool dirty = is_dirty(set_index, way);
+        invalidate_way(set_index, way);
+        return dirty;
+    }
+    
+    // Exclusive level: install a block evicted from the level above
+    void victim_fill(unsigned long address, bool dirty) {
+        unsigned long block_addr = block_of(address);
+        int set_index = set_of(block_addr);
+        unsigned long tag = tag_of(block_addr);
+        stats.victim_fills++;
+        int way = find_way(set_index, tag);
+        if (way >= 0) {
+            update_replacement(set_index, way);
+            if (dirty) {
+                set_dirty(set_index, way, true);
+            }
+            return;
+        }
+        insert_block(set_index, tag, dirty, false);
+    }
+    
+    // Drop a block from this level and every level above (an inclusive level below
+    // evicted it). Returns true if any dropped copy was dirty.
+    bool back_invalidate(unsigned long address) {
+        bool dirty = false;
+        if (is_enabled()) {
+            unsigned long block_addr = block_of(address);
+            int set_index = set_of(block_addr);
+            int way = find_way(set_index, tag_of(block_addr));
+            if (way >= 0) {
+                dirty = is_dirty(set_index, way);
+                invalidate_way(set_index, way);
+                stats.back_invalidations++;
+            }
+        }
+        if (upper_level != nullptr) {
+            dirty |= upper_level->back_invalidate(address);
+        }
+        return dirty;
+    }
+    
+    void invalidate_way(int set_index, int way) {
+        set_fill[set_index]--;
+        set_valid(set_index, way, false);
+        set_dirty(set_index, way, false);
+        tags[tag_index(set_index, way)] = 0;
+    }
+    
+    // Handle memory operations (placeholder for actual memory interface)
+    void handle_memory_write(unsigned long /* address */) {
+        // In a real implementation, this would interface with main memory
+        // For simulation purposes, we just count the transfer
+        stats.memory_traffic++;
+    }
+    
+    void handle_memory_read(unsigned long /* address */) {
+        // In a real implementation, this would interface with main memory
+        // For simulation purposes, we just count the transfer
+        stats.memory_traffic++;
+    }
+    
+    // Handle writeback of dirty block to next level (legacy method)
+    void handle_writeback(int set_index, int way) {
+        // This method is kept for backward compatibility
+        // The new two-step allocation process handles writebacks directly
+        set_dirty(set_index, way, false);
+    }
+    
+    // Copy one set's blocks and replacement state from a cache of identical geometry
+    void adopt_set(const CacheT& other, int set_index) {
+        size_t first = tag_index(set_index, 0);
+        std::copy(other.tags.begin() + first, other.tags.begin() + first + associativity, tags.begin() + first);
+        policy.copy_set(other.policy, set_index);
+        set_fill[set_index] = other.set_fill[set_index];
+        size_t word = static_cast<size_t>(set_index) * words_per_set;
+        std::copy(other.valid_bits.begin() + word, other.valid_bits.begin() + word + words_per_set,
+                  valid_bits.begin() + word);
+        for (int w = 0; w < words_per_set; w++) {
+            dirty_blocks += __builtin_popcountll(other.dirty_bits[word + w]);
+            dirty_blocks -= __builtin_popcountll(dirty_bits[word + w]);
+            dirty_bits[word + w] = other.dirty_bits[word + w];
+        }
+    }
+    
+    // Snapshot of one block's state
+    CacheBlock get_block(int set_index, int way) const {
+        CacheBlock block;
+        block.valid = is_valid(set_index, way);
+        block.dirty = is_dirty(set_index, way);
+        block.tag = block_tag(set_index, way);
+        return block;
+    }
+    
+    // Convenience methods for specific access types
+    bool read(unsigned long address) {
+        return access(address, false);
+    }
+    
+    bool write(unsigned long address) {
+        return access(address, true);
+    }
+    
+    // Get statistics about dirty blocks (maintained incrementally, O(1))
+    int get_dirty_blocks_count() const {
+        return static_cast<int>(dirty_blocks);
+    }
+    
+    // Check if this cache has a next level
+    bool has_next_level() const {
+        return next_level != nullptr;
+    }
+    
+    // Get cache level name for debugging: L<depth>, counted from the level nearest the CPU
+    std::string get_level_name() const {
+        int depth = 1;
+        for (const CacheT* level = upper_level; level != nullptr; level = level->upper_level) {
+            depth++;
+        }
+        return "L" + std::to_string(depth) + (next_level == nullptr ? " (last level)" : "");
+    }
+    
+    // Debug method to check block state
+    void print_block_state(int set_index, int way) const {
+        const CacheBlock block = get_block(set_index, way);
+        std::cout << "Block[" << set_index << "][" << way << "]: "
+                  << "Valid=" << (block.valid ? "Y" : "N") << ", "
+                  << "Dirty=" << (block.dirty ? "Y" : "N") << ", "
+                  << "Tag=0x" << std::hex << block.tag << std::dec << std::endl;
+    }
+    
+    // Debug method to print the replacement order for a set (LRU: MRU->LRU)
+    void print_replacement_order(int set_index) const {
+        std::vector<int> ways;
+        policy.order(set_index, ways);
+        std::cout << "Set " << set_index << " " << Policy::name() << " order: ";
+        for (int way : ways) {
+            std::cout << way << " ";
+        }
+        std::cout << std::endl;
+    }
+    
+    // Validate that all state is consistent
+    bool validate_cache_state() const {
+        for (int set = 0; set < num_sets; set++) {
+            int valid = 0;
+            for (int way = 0; way < associativity; way++) {
+                valid += is_valid(set, way);
+            }
+            if (valid != set_fill[set]) return false;
+        }
+        return policy.validate();
+    }
+    
+    // Get cache statistics
+    struct CacheStats {
+        unsigned long reads;
+        unsigned long writes;
+        unsigned long read_hits;
+        unsigned long write_hits;
+        unsigned long read_misses;
+        unsigned long write_misses;
+        unsigned long writebacks;
+        
+        // AAT (Average Access Time) parameters
+        int hit_time;           // Cache hit time in cycles
+        int miss_penalty;       // Miss penalty in cycles
+        double area_mm2;        // Cache area in mm²
+        
+        unsigned long prefetches;        // Blocks prefetched into stream buffers
+        unsigned long prefetch_hits;     // Cache misses served by a stream buffer
+        unsigned long memory_traffic;    // Blocks this level moved to or from main memory
+        unsigned long back_invalidations;  // Blocks dropped because an inclusive level below evicted them
+        unsigned long victim_fills;        // Blocks received from the level above (exclusive level)
+        unsigned long compulsory_misses;   // Three-C classification (with classify_misses)
+        unsigned long capacity_misses;
+        unsigned long conflict_misses;
+        
+        CacheStats() : reads(0), writes(0), read_hits(0), write_hits(0), 
+                       read_misses(0), write_misses(0), writebacks(0),
+                       hit_time(1), miss_penalty(100), area_mm2(0.0),
+                       prefetches(0), prefetch_hits(0), memory_traffic(0),
+                       back_invalidations(0), victim_fills(0), compulsory_misses(0),
+                       capacity_misses(0), conflict_misses(0) {}
+        
+        // Accumulate the event counters of another run (timing/area are left as is)
+        void merge(const CacheStats& other) {
+            reads += other.reads;
+            writes += other.writes;
+            read_hits += other.read_hits;
+            write_hits += other.write_hits;
+            read_misses += other.read_misses;
+            write_misses += other.write_misses;
+            writebacks += other.writebacks;
+            prefetches += other.prefetches;
+            prefetch_hits += other.prefetch_hits;
+            memory_traffic += other.memory_traffic;
+            back_invalidations += other.back_invalidations;
+            victim_fills += other.victim_fills;
+            compulsory_misses += other.compulsory_misses;
+            capacity_misses += other.capacity_misses;
+            conflict_misses += other.conflict_misses;
+        }
+        
+        // Remove the event counters of an earlier snapshot (timing/area are left as is)
+        void subtract(const CacheStats& other) {
+            reads -= other.reads;
+            writes -= other.writes;
+            read_hits -= other.read_hits;
+            write_hits -= other.write_hits;
+            read_misses -= other.read_misses;
+            write_misses -= other.write_misses;
+            writebacks -= other.writebacks;
+            prefetches -= other.prefetches;
+            prefetch_hits -= other.prefetch_hits;
+            memory_traffic -= other.memory_traffic;
+            back_invalidations -= other.back_invalidations;
+            victim_fills -= other.victim_fills;
+            compulsory_misses -= other.compulsory_misses;
+            capacity_misses -= other.capacity_misses;
+            conflict_misses -= other.conflict_misses;
+        }
+        
+        // Visit every event counter (not timing/area) as visit(name, counter)
+        template <class Visitor>
+        void for_each_counter(Visitor visit) {
+            visit_counters(*this, visit);
+        }
+        
+        template <class Visitor>
+        void for_each_counter(Visitor visit) const {
+            visit_counters(*this, visit);
+        }
+        
+        template <class Stats, class Visitor>
+        static void visit_counters(Stats& stats, Visitor& visit) {
+            visit("reads", stats.reads);
+            visit("writes", stats.writes);
+            visit("read_hits", stats.read_hits);
+            visit("write_hits", stats.write_hits);
+            visit("read_misses", stats.read_misses);
+            visit("write_misses", stats.write_misses);
+            visit("writebacks", stats.writebacks);
+            visit("prefetches", stats.prefetches);
+            visit("prefetch_hits", stats.prefetch_hits);
+            visit("memory_traffic", stats.memory_traffic);
+            visit("back_invalidations", stats.back_invalidations);
+            visit("victim_fills", stats.victim_fills);
+            visit("compulsory_misses", stats.compulsory_misses);
+            visit("capacity_misses", stats.capacity_misses);
+            visit("conflict_misses", stats.conflict_misses);
+        }
+        
+        // Extrapolate sampled event counters to the whole run
+        void scale(double factor) {
+            for_each_counter([factor](const char*, unsigned long& counter) {
+                counter = static_cast<unsigned long>(std::llround(counter * factor));
+            });
+        }
+                       
+        double get_read_miss_rate() const {
+            return reads > 0 ? (double)read_misses / reads : 0.0;
+        }
+        
+        double get_write_miss_rate() const {
+            return writes > 0 ? (double)write_misses / writes : 0.0;
+        }
+        
+        double get_overall_miss_rate() const {
+            unsigned long total = reads + writes;
+            unsigned long total_misses = read_misses + write_misses;
+            return total > 0 ? (double)total_misses / total : 0.0;
+        }
+        
+        // Calculate Average Access Time (AAT)
+        double get_aat() const {
+            double miss_rate = get_overall_miss_rate();
+            return hit_time + (miss_rate * miss_penalty);
+        }
+        
+        // AAT seen by the CPU when misses are served by the level whose stats are next:
+        // hit_time + miss_rate * (next hit time + next demand read miss rate * next miss penalty)
+        double get_hierarchical_aat(const CacheStats& next) const {
+            double next_aat = next.hit_time + next.get_read_miss_rate() * next.miss_penalty;
+            return hit_time + get_overall_miss_rate() * next_aat;
+        }
+        
+        // Calculate effective access time including write considerations
+        double get_effective_aat() const {
+            if (reads + writes == 0) return 0.0;
+            
+            double read_miss_rate = get_read_miss_rate();
+            double write_miss_rate = get_write_miss_rate();
+            double read_ratio = (double)reads / (reads + writes);
+            double write_ratio = (double)writes / (reads + writes);
+            
+            // Weighted AAT considering read/write mix
+            double read_aat = hit_time + (read_miss_rate * miss_penalty);
+            double write_aat = hit_time + (write_miss_rate * miss_penalty);
+            
+            return (read_ratio * read_aat) + (write_ratio * write_aat);
+        }
+        
+        // Performance per area metric
+        double get_performance_per_area() const {
+            if (area_mm2 <= 0.0) return 0.0;
+            double aat = get_aat();
+            return aat > 0.0 ? (1.0 / aat) / area_mm2 : 0.0;
+        }
+    };
+    
+    // Statistics tracking
+    mutable CacheStats stats;
+    
+    // Print cache contents (blocks in replacement order, MRU to LRU for LRU; only valid blocks)
+    void print_cache_contents(const std::string& cache_name) const {
+        std::cout << "===== " << cache_name << " contents =====" << std::endl;
+        
+        bool has_valid_blocks = false;
+        std::vector<int> ways;
+        
+        for (int set = 0; set < num_sets; set++) {
+            std::vector<std::pair<int, CacheBlock>> valid_blocks;
+            
+            // Collect valid blocks in replacement order (LRU: MRU first)
+            policy.order(set, ways);
+            for (int way : ways) {
+                if (is_valid(set, way)) {
+                    valid_blocks.push_back({way, get_block(set, way)});
+                }
+            }
+            
+            // Only print set if it has valid blocks
+            if (!valid_blocks.empty()) {
+                std::cout << "Set " << std::setfill(' ') << std::setw(3) << set << ":";
+                
+                for (const auto& block_pair : valid_blocks) {
+                    const CacheBlock& block = block_pair.second;
+                    std::cout << " " << std::hex << std::setfill('0') << std::setw(8) << block.tag;
+                    if (block.dirty) {
+                        std::cout << " D";
+                    }
+                }
+                std::cout << std::dec << std::endl;
+                has_valid_blocks = true;
+            }
+        }
+        
+        if (!has_valid_blocks) {
+            std::cout << "Empty" << std::endl;
+        }
+        
+        std::cout << std::endl;
+    }
+    
+    // Print stream buffer contents, most recently used buffer first
+    void print_stream_buffers() const {
+        if (prefetch_buffers == 0) return;
+        
+        std::cout << "===== Stream Buffer(s) contents =====" << std::endl;
+        std::vector<int> order;
+        for (int i = 0; i < prefetch_buffers; i++) {
+            if (stream_last_use[i] != 0) {
+                order.push_back(i);
+            }
+        }
+        std::sort(order.begin(), order.end(),
+                  [this](int a, int b) { return stream_last_use[a] > stream_last_use[b]; });
+        for (int stream : order) {
+            for (int i = 0; i < prefetch_depth; i++) {
+                std::cout << " " << std::hex << std::setfill('0') << std::setw(8) << stream_base[stream] + i;
+            }
+            std::cout << std::dec << std::endl;
+        }
+        std::cout << std::endl;
+    }
+    
+    // Access with statistics tracking
+    bool access_with_stats(unsigned long address, bool is_write = false) {
+        bool hit = access(address, is_write);
+        
+        // Update statistics
+        if (is_write) {
+            stats.writes++;
+            if (hit) {
+                stats.write_hits++;
+            } else {
+                stats.write_misses++;
+            }
+        } else {
+            stats.reads++;
+            if (hit) {
+                stats.read_hits++;
+            } else {
+                stats.read_misses++;
+            }
+        }
+        
+        return hit;
+    }
+    
+    // Functional warming: the tag, valid, dirty and replacement updates of access(),
+    // with fetches and dirty evictions warming the next level the same way. Statistics,
+    // miss classification and stream buffers are left untouched. Non-inclusive
+    // hierarchies only (inclusive and exclusive levels take the full path).
+    void warm(unsigned long address, bool is_write) {
+        if (!is_enabled()) return;
+        if (classifier || inclusion != InclusionPolicy::NINE ||
+            (next_level != nullptr && next_level->inclusion != InclusionPolicy::NINE)) {
+            access(address, is_write);
+            return;
+        }
+        
+        unsigned long block_addr = block_of(address);
+        int set_index = set_of(block_addr);
+        unsigned long tag = tag_of(block_addr);
+        int way = find_way(set_index, tag);
+        if (way >= 0) {
+            update_replacement(set_index, way);
+            if (is_write) {
+                set_dirty(set_index, way, true);
+            }
+            return;
+        }
+        
+        way = get_victim(set_index);
+        if (is_valid(set_index, way)) {
+            if (is_dirty(set_index, way) && next_level != nullptr) {
+                next_level->warm(address_of(block_tag(set_index, way), set_index), true);
+            }
+            invalidate_way(set_index, way);
+        }
+        if (next_level != nullptr) {
+            next_level->warm(address_of(tag, set_index), false);
+        }
+        set_fill[set_index]++;
+        set_valid(set_index, way, true);
+        tags[tag_index(set_index, way)] = tag;
+        set_dirty(set_index, way, is_write);
+        policy.on_fill(set_index, way);
+    }
+    
+    // access_with_stats over a span of decoded records, in order. Each chunk is handled
+    // in two passes. The first computes every block address and set index; with a
+    // power-of-two geometry this is a branch-free shift/mask loop. It also prefetches
+    // each target set's tag and valid-bit lines. The second resolves the accesses
+    // against the now-cached sets, counting statistics without data-dependent branches.
+    // Record is any type with address and operation members (TraceEntry).
+    template <class Record>
+    void access_batch(const Record* records, size_t count) {
+        static_assert(!Policy::NEEDS_FUTURE, "OPT needs set_next_use() before every access");
+        if (!is_enabled()) {
+            for (size_t i = 0; i < count; i++) {
+                access_with_stats(records[i].address, records[i].operation == 'w');
+            }
+            return;
+        }
+        
+        const size_t CHUNK = 64;
+        unsigned long block_addrs[CHUNK];
+        int set_indices[CHUNK];
+        for (size_t first = 0; first < count; first += CHUNK) {
+            const Record* chunk = records + first;
+            size_t n = std::min(CHUNK, count - first);
+            if (pow2_geometry) {
+                for (size_t i = 0; i < n; i++) {
+                    block_addrs[i] = chunk[i].address >> offset_bits;
+                    set_indices[i] = static_cast<int>(block_addrs[i] & index_mask);
+                }
+            } else {
+                for (size_t i = 0; i < n; i++) {
+                    block_addrs[i] = block_of(chunk[i].address);
+                    set_indices[i] = set_of(block_addrs[i]);
+                }
+            }
+            for (size_t i = 0; i < n; i++) {
+                __builtin_prefetch(&tags[tag_index(set_indices[i], 0)]);
+                __builtin_prefetch(&valid_bits[static_cast<size_t>(set_indices[i]) * words_per_set]);
+            }
+            
+            unsigned long writes = 0, read_hits = 0, write_hits = 0;
+            for (size_t i = 0; i < n; i++) {
+                bool is_write = (chunk[i].operation == 'w');
+                bool hit = access_block(block_addrs[i], set_indices[i], tag_of(block_addrs[i]), is_write);
+                writes += is_write;
+                read_hits += hit & !is_write;
+                write_hits += hit & is_write;
+            }
+            stats.reads += n - writes;
+            stats.writes += writes;
+            stats.read_hits += read_hits;
+            stats.write_hits += write_hits;
+            stats.read_misses += n - writes - read_hits;
+            stats.write_misses += writes - write_hits;
+        }
+    }
+    
+    // Get statistics
+    const CacheStats& get_stats() const {
+        return stats;
+    }
+    
+    // Reset statistics
+    void reset_stats() {
+        stats = CacheStats();
+    }
+    
+    // Empty the cache (all ways invalid, replacement and stream buffers reset, statistics
+    // cleared but timing kept) for another run, reusing its storage
+    void reset() {
+        if (is_enabled()) {
+            clear_storage();
+        }
+        std::fill(stream_last_use.begin(), stream_last_use.end(), 0);
+        stream_clock = 0;
+        rebuild_stream_index();
+        if (classifier) {
+            classify_misses();
+        }
+        CacheStats cleared;
+        cleared.hit_time = stats.hit_time;
+        cleared.miss_penalty = stats.miss_penalty;
+        cleared.area_mm2 = stats.area_mm2;
+        stats = cleared;
+    }
+    
+    // Bytes of storage backing the tag store and replacement state
+    size_t storage_bytes() const {
+        return storage_capacity;
+    }
+    
+    // Checkpoint image (host byte order): geometry, the used part of the storage block
+    // (tags, valid/dirty bitmaps, set fill and replacement state are all in it), the
+    // stream buffers and the event counters. Timing parameters are not saved, so a
+    // restored cache keeps the latencies of the run that restores it.
+    void save_state(std::ostream& out) const {
+        int32_t geometry[3] = {block_size, size, associativity};
+        out.write(reinterpret_cast<const char*>(geometry), sizeof(geometry));
+        uint64_t bytes = storage_used;
+        out.write(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+        out.write(reinterpret_cast<const char*>(storage), bytes);
+        
+        int32_t prefetcher[2] = {prefetch_buffers, prefetch_depth};
+        out.write(reinterpret_cast<const char*>(prefetcher), sizeof(prefetcher));
+        out.write(reinterpret_cast<const char*>(&stream_clock), sizeof(stream_clock));
+        for (int i = 0; i < prefetch_buffers; i++) {
+            uint64_t entry[2] = {stream_base[i], stream_last_use[i]};
+            out.write(reinterpret_cast<const char*>(entry), sizeof(entry));
+        }
+        
+        stats.for_each_counter([&out](const char*, unsigned long counter) {
+            uint64_t value = counter;
+            out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        });
+    }
+    
+    // Load an image written by save_state into a cache of the same geometry and policy.
+    // Stream buffers are restored only when the prefetcher configuration matches;
+    // otherwise they start empty. Returns an error message, or "" on success.
+    std::string load_state(std::istream& in) {
+        int32_t geometry[3];
+        uint64_t bytes = 0;
+        in.read(reinterpret_cast<char*>(geometry), sizeof(geometry));
+        in.read(reinterpret_cast<char*>(&bytes), sizeof(bytes));
+        if (!in) {
+            return "truncated checkpoint";
+        }
+        if (geometry[0] != block_size || geometry[1] != size || geometry[2] != associativity ||
+            bytes != storage_used) {
+            return "checkpoint geometry " + std::to_string(geometry[0]) + "/" + std::to_string(geometry[1]) + "/" +
+                   std::to_string(geometry[2]) + " does not match the cache";
+        }
+        in.read(reinterpret_cast<char*>(storage), bytes);
+        dirty_blocks = 0;
+        for (uint64_t word : dirty_bits) {
+            dirty_blocks += __builtin_popcountll(word);
+        }
+        
+        int32_t prefetcher[2];
+        uint64_t clock = 0;
+        in.read(reinterpret_cast<char*>(prefetcher), sizeof(prefetcher));
+        in.read(reinterpret_cast<char*>(&clock), sizeof(clock));
+        bool same_prefetcher = prefetcher[0] == prefetch_buffers && prefetcher[1] == prefetch_depth;
+        for (int i = 0; in && i < prefetcher[0]; i++) {
+            uint64_t entry[2];
+            in.read(reinterpret_cast<char*>(entry), sizeof(entry));
+            if (same_prefetcher) {
+                stream_base[i] = entry[0];
+                stream_last_use[i] = entry[1];
+            }
+        }
+        if (same_prefetcher) {
+            stream_clock = clock;
+            rebuild_stream_index();
+        }
+        
+        stats.for_each_counter([&in](const char*, unsigned long& counter) {
+            uint64_t value = 0;
+            in.read(reinterpret_cast<char*>(&value), sizeof(value));
+            counter = value;
+        });
+        if (!in) {
+            return "truncated checkpoint";
+        }
+        if (!policy.validate()) {
+            return "corrupt replacement state in checkpoint";
+        }
+        return "";
+    }
+    
+    // Way to fill for a miss: the first invalid way, otherwise the policy's victim
+    int get_victim(int set_index) {
+        if (set_fill[set_index] < associativity) {
+            const uint64_t* set_valid = &valid_bits[static_cast<size_t>(set_index) * words_per_set];
+            for (int word = 0; word < words_per_set; word++) {
+                if (~set_valid[word] != 0) {
+                    return word * 64 + __builtin_ctzll(~set_valid[word]);
+                }
+            }
+        }
+        return policy.victim(set_index);
+    }
+    
+    // Update replacement state when a block is accessed
+    void update_replacement(int set_index, int way) {
+        policy.on_hit(set_index, way);
+    }
+    
+    // Replacement policy state (OPT receives next-use positions through this)
+    Policy& replacement_policy() {
+        return policy;
+    }
+    
+    // Validate cache configuration according to requirements
+    bool is_valid_configuration() const {
+        if (!is_enabled()) return true; // Disabled cache is valid
+        
+        // Check if block size is power of 2
+        if (!is_power_of_two(block_size)) {
+            return false;
+        }
+        
+        // Check if number of sets is power of 2
+        if (!is_power_of_two(num_sets)) {
+            return false;
+        }
+        
+        // Check basic constraints
+        if (block_size <= 0 || size <= 0 || associativity <= 0) {
+            return false;
+        }
+        
+        // Check if associativity doesn't exceed total blocks
+        if (associativity > num_blocks) {
+            return false;
+        }
+        
+        // Check if size is divisible by block_size
+        if (size % block_size != 0) {
+            return false;
+        }
+        
+        // Check if num_blocks is divisible by associativity
+        if (num_blocks % associativity != 0) {
+            return false;
+        }
+        
+        return true;
+    }
+    
+    // Get configuration error message
+    std::string get_config_error() const {
+        if (!is_enabled()) return "";
+        
+        if (block_size <= 0) return "Block size must be positive";
+        if (size <= 0) return "Cache size must be positive";
+        if (associativity <= 0) return "Associativity must be positive";
+        
+        if (!is_power_of_two(block_size)) {
+            return "Block size must be a power of 2";
+        }
+        
+        if (size % block_size != 0) {
+            return "Cache size must be divisible by block size";
+        }
+        
+        if (num_blocks % associativity != 0) {
+            return "Number of blocks must be divisible by associativity";
+        }
+        
+        if (!is_power_of_two(num_sets)) {
+            return "Number of sets must be a power of 2";
+        }
+        
+        if (associativity > num_blocks) {
+            return "Associativity cannot exceed total number of blocks";
+        }
+        
+        return "";
+    }
+
+private:
+    // Place every per-set array in the storage block behind layout
+    void layout_storage(StorageLayout& layout) {
+        layout.place(tags, static_cast<size_t>(num_sets) * associativity);
+        layout.place(valid_bits, static_cast<size_t>(num_sets) * words_per_set);
+        layout.place(dirty_bits, static_cast<size_t>(num_sets) * words_per_set);
+        layout.place(set_fill, num_sets);
+        policy.layout(layout, num_sets, associativity);
+    }
+    
+    // All ways invalid, clean, tag 0, and fresh replacement state
+    void clear_storage() {
+        tags.fill(0);
+        valid_bits.fill(0);
+        dirty_bits.fill(0);
+        dirty_blocks = 0;
+        set_fill.fill(0);
+        policy.init();
+    }
+    
+    // Size the storage block for the geometry (growing it only when needed), bind the
+    // arrays to it and clear them
+    void initialize_cache() {
+        words_per_set = (associativity + 63) / 64;
+        StorageLayout measure;
+        layout_storage(measure);
+        if (measure.bytes() > storage_capacity || !storage) {
+            if (arena) {
+                storage = arena->allocate(measure.bytes());
+            } else {
+                owned_storage = allocate_aligned_storage(measure.bytes());
+                storage = owned_storage.get();
+            }
+            if (!storage) {
+                throw std::bad_alloc();
+            }
+            storage_capacity = measure.bytes();
+        }
+        storage_used = measure.bytes();
+        StorageLayout bind(storage);
+        layout_storage(bind);
+        clear_storage();
+        
+        pow2_geometry = is_power_of_two(block_size) && is_power_of_two(num_sets);
+        offset_bits = pow2_geometry ? __builtin_ctz(block_size) : 0;
+        index_bits = pow2_geometry ? __builtin_ctz(num_sets) : 0;
+        index_mask = pow2_geometry ? static_cast<unsigned long>(num_sets) - 1 : 0;
+    }
+    
+    // Block address / set index / tag of an address, and the address of a (tag, set) block
+    unsigned long block_of(unsigned long address) const {
+        return pow2_geometry ? address >> offset_bits : address / block_size;
+    }
+    
+    int set_of(unsigned long block_addr) const {
+        return static_cast<int>(pow2_geometry ? block_addr & index_mask : block_addr % num_sets);
+    }
+    
+    unsigned long tag_of(unsigned long block_addr) const {
+        return pow2_geometry ? block_addr >> index_bits : block_addr / num_sets;
+    }
+    
+    unsigned long address_of(unsigned long tag, int set_index) const {
+        if (pow2_geometry) {
+            return ((tag << index_bits) | static_cast<unsigned long>(set_index)) << offset_bits;
+        }
+        return (tag * num_sets + set_index) * block_size;
+    }
+    
+    // Most recently used stream buffer holding block_addr, other than skip, or -1
+    int scan_streams(unsigned long block_addr, int skip = -1) const {
+        int found = -1;
+        uint64_t found_use = 0;
+        for (int i = 0; i < prefetch_buffers; i++) {
+            bool hit = i != skip && stream_last_use[i] > found_use &&
+                       block_addr - stream_base[i] < static_cast<unsigned long>(prefetch_depth);
+            found = hit ? i : found;
+            found_use = hit ? stream_last_use[i] : found_use;
+        }
+        return found;
+    }
+    
+    // Most recently used stream buffer holding block_addr, or -1
+    int find_stream(unsigned long block_addr) const {
+        uint64_t entry = stream_index.find(block_addr, 0);
+        uint32_t holders = static_cast<uint32_t>(entry);
+        if (holders <= 1) {
+            return holders == 0 ? -1 : static_cast<int>(entry >> 32);
+        }
+        return scan_streams(block_addr);
+    }
+    
+    // Stream index upkeep as block enters or leaves a buffer's window
+    void index_stream_block(unsigned long block_addr, int stream) {
+        uint64_t entry = stream_index.find(block_addr, 0);
+        stream_index.exchange(block_addr, (static_cast<uint64_t>(stream) << 32) | (static_cast<uint32_t>(entry) + 1), 0);
+    }
+    
+    void unindex_stream_block(unsigned long block_addr, int stream) {
+        uint32_t holders = static_cast<uint32_t>(stream_index.find(block_addr, 0)) - 1;
+        if (holders == 0) {
+            stream_index.erase(block_addr);
+        } else {
+            // The single remaining holder must be named again
+            int holder = holders == 1 ? scan_streams(block_addr, stream) : 0;
+            stream_index.exchange(block_addr, (static_cast<uint64_t>(holder) << 32) | holders, 0);
+        }
+    }
+    
+    // Index every valid buffer from scratch (after a reset or a restored checkpoint)
+    void rebuild_stream_index() {
+        size_t slots = 1;
+        while (slots < 4 * static_cast<size_t>(prefetch_buffers) * prefetch_depth) {
+            slots <<= 1;
+        }
+        stream_index = BlockPositionTable(slots);
+        for (int i = 0; i < prefetch_buffers; i++) {
+            for (int j = 0; stream_last_use[i] != 0 && j < prefetch_depth; j++) {
+                index_stream_block(stream_base[i] + j, i);
+            }
+        }
+    }
+    
+    // Slide a buffer past block_addr, prefetching the blocks that enter its window
+    void advance_stream(int stream, unsigned long block_addr) {
+        unsigned long base = stream_base[stream];
+        unsigned long issued = block_addr + 1 - base;
+        for (unsigned long i = 0; i < issued; i++) {
+            unindex_stream_block(base + i, stream);
+            index_stream_block(base + prefetch_depth + i, stream);
+        }
+        stats.prefetches += issued;
+        stats.memory_traffic += issued;
+        stream_base[stream] = block_addr + 1;
+        stream_last_use[stream] = ++stream_clock;
+    }
+    
+    // Refill the least recently used buffer with the blocks following block_addr
+    void allocate_stream(unsigned long block_addr) {
+        int victim = 0;
+        for (int i = 1; i < prefetch_buffers; i++) {
+            if (stream_last_use[i] < stream_last_use[victim]) {
+                victim = i;
+            }
+        }
+        for (int j = 0; stream_last_use[victim] != 0 && j < prefetch_depth; j++) {
+            unindex_stream_block(stream_base[victim] + j, victim);
+        }
+        for (int j = 0; j < prefetch_depth; j++) {
+            index_stream_block(block_addr + 1 + j, victim);
+        }
+        stats.prefetches += prefetch_depth;
+        stats.memory_traffic += prefetch_depth;
+        stream_base[victim] = block_addr + 1;
+        stream_last_use[victim] = ++stream_clock;
+    }
+    
+    // Position of a way in the flat tag array
+    size_t tag_index(int set_index, int way) const {
+        return static_cast<size_t>(set_index) * associativity + way;
+    }
+    
+    unsigned long block_tag(int set_index, int way) const {
+        return tags[tag_index(set_index, way)];
+    }
+    
+    // Valid/dirty bitmap accessors
+    bool is_valid(int set_index, int way) const {
+        return (valid_bits[static_cast<size_t>(set_index) * words_per_set + (way >> 6)] >> (way & 63)) & 1;
+    }
+    
+    bool is_dirty(int set_index, int way) const {
+        return (dirty_bits[static_cast<size_t>(set_index) * words_per_set + (way >> 6)] >> (way & 63)) & 1;
+    }
+    
+    static void assign_bit(uint64_t& word, int bit, bool value) {
+        uint64_t mask = uint64_t(1) << bit;
+        word = value ? (word | mask) : (word & ~mask);
+    }
+    
+    void set_valid(int set_index, int way, bool value) {
+        assign_bit(valid_bits[static_cast<size_t>(set_index) * words_per_set + (way >> 6)], way & 63, value);
+    }
+    
+    void set_dirty(int set_index, int way, bool value) {
+        uint64_t& word = dirty_bits[static_cast<size_t>(set_index) * words_per_set + (way >> 6)];
+        dirty_blocks += static_cast<unsigned long>(value) - ((word >> (way & 63)) & 1);
+        assign_bit(word, way & 63, value);
+    }
+    
+    // Tag search with the associativity known at compile time: the compare loop is fully
+    // unrolled (and vectorized) into one match mask, ANDed with the set's valid word
+    template <int Ways>
+    int find_way_fixed(int set_index, uint64_t tag) const {
+        static_assert(Ways <= 64, "one valid-bit word per set");
+        const uint64_t* set_tags = &tags[static_cast<size_t>(set_index) * Ways];
+        uint64_t match = 0;
+        for (int way = 0; way < Ways; way++) {
+            match |= static_cast<uint64_t>(set_tags[way] == tag) << way;
+        }
+        match &= valid_bits[set_index];
+        return match != 0 ? __builtin_ctzll(match) : -1;
+    }
+    
+    // Find the valid way holding tag, or -1 on a miss. Common associativities use a
+    // compile-time specialization; otherwise all ways of a SIMD group are compared at
+    // once and the equality mask is ANDed with the set's valid bits.
+    int find_way(int set_index, uint64_t tag) const {
+        switch (associativity) {
+        case 1: return find_way_fixed<1>(set_index, tag);
+        case 2: return find_way_fixed<2>(set_index, tag);
+        case 4: return find_way_fixed<4>(set_index, tag);
+        case 8: return find_way_fixed<8>(set_index, tag);
+        case 16: return find_way_fixed<16>(set_index, tag);
+        default: break;
+        }
+        
+        const uint64_t* set_tags = &tags[tag_index(set_index, 0)];
+        const uint64_t* set_valid = &valid_bits[static_cast<size_t>(set_index) * words_per_set];
+        int way = 0;
+        
+#if defined(__AVX2__)
+        const __m256i needle = _mm256_set1_epi64x(static_cast<long long>(tag));
+        for (; way + 4 <= associativity; way += 4) {
+            __m256i group = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(set_tags + way));
+            unsigned mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(group, needle)));
+            mask &= static_cast<unsigned>(set_valid[way >> 6] >> (way & 63)) & 0xF;
+            if (mask != 0) {
+                return way + __builtin_ctz(mask);
+            }
+        }
+#elif defined(__SSE2__)
+        const __m128i needle = _mm_set1_epi64x(static_cast<long long>(tag));
+        for (; way + 2 <= associativity; way += 2) {
+            __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set_tags + way));
+            // 64-bit equality from 32-bit compares: both halves of a lane must match
+            __m128i eq32 = _mm_cmpeq_epi32(group, needle);
+            __m128i eq64 = _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+            unsigned mask = _mm_movemask_pd(_mm_castsi128_pd(eq64));
+            mask &= static_cast<unsigned>(set_valid[way >> 6] >> (way & 63)) & 0x3;
+            if (mask != 0) {
+                return way + __builtin_ctz(mask);
+            }
+        }
+#elif defined(__ARM_NEON)
+        const uint64x2_t needle = vdupq_n_u64(tag);
+        for (; way + 2 <= associativity; way += 2) {
+            uint64x2_t eq = vceqq_u64(vld1q_u64(set_tags + way), needle);
+            unsigned mask = static_cast<unsigned>(vgetq_lane_u64(eq, 0) & 1) |
+                            static_cast<unsigned>((vgetq_lane_u64(eq, 1) & 1) << 1);
+            mask &= static_cast<unsigned>(set_valid[way >> 6] >> (way & 63)) & 0x3;
+            if (mask != 0) {
+                return way + __builtin_ctz(mask);
+            }
+        }
+#endif
+        
+        // Scalar fallback and remainder ways
+        for (; way < associativity; way++) {
+            if (set_tags[way] == tag && ((set_valid[way >> 6] >> (way & 63)) & 1)) {
+                return way;
+            }
+        }
+        return -1;
+    }
+    
+    // Helper function to check if a number is power of 2
+    bool is_power_of_two(int n) const {
+        return n > 0 && (n & (n - 1)) == 0;
+    }
+    
+    // Recalculate derived parameters when base parameters change
+    void recalculate_parameters() {
+        if (is_enabled()) {
+            num_blocks = size / block_size;
+            num_sets = num_blocks / associativity;
+            initialize_cache();
+        } else {
+            num_blocks = 0;
+            num_sets = 0;
+            tags = FlatArray<uint64_t>();
+            valid_bits = FlatArray<uint64_t>();
+            dirty_bits = FlatArray<uint64_t>();
+            dirty_blocks = 0;
+            set_fill = FlatArray<int>();
+        }
+    }
+};
+
+// The default hierarchy uses true LRU
+using Cache = CacheT<LruPolicy>;
+
+// Trace file processing functions
+// Text records are "[<core>] <r|w|i> <hex_address>": multi-core traces tag each record
+// with the decimal ID of the issuing core (default 0) and may mark instruction fetches
+// with 'i'. Single-stream modes ignore the core and treat a fetch as a read.
+struct TraceEntry {
+    char operation;              // 'r' for read, 'w' for write, 'i' for instruction fetch
+    unsigned long address;       // Hexadecimal address, up to 64 bits
+    int core;                    // Issuing core (multi-core traces)
+    
+    TraceEntry(char op, unsigned long addr, int c = 0) : operation(op), address(addr), core(c) {}
+    
+    // Helper to format address as 8-digit hex (showing leading zeros)
+    std::string get_formatted_address() const {
+        std::ostringstream oss;
+        oss << std::hex << std::setfill('0') << std::setw(8) << address;
+        return oss.str();
+    }
+};
+
+const int MAX_TRACE_CORES = 1024;
+
+// Whitespace as skipped by stream extraction in the "C" locale
+inline bool is_trace_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+inline int hex_digit_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Parse one trace record "<r|w> <hex_address>" from [begin, end) without allocating.
+// Accepts exactly what the stream/std::stoul parser accepted: the first two
+// whitespace-separated tokens, an optional sign and 0x prefix, and hex digits up
+// to the first non-hex character. Anything after the address token is ignored.
+bool parse_trace_record(const char* begin, const char* end, TraceEntry& entry) {
+    PROFILE_SCOPE(PROFILE_PARSE);
+    const char* p = begin;
+    
+    // Optional core tag: a decimal token before the operation
+    while (p < end && is_trace_space(*p)) p++;
+    int core = 0;
+    if (p < end && *p >= '0' && *p <= '9') {
+        for (; p < end && *p >= '0' && *p <= '9'; p++) {
+            core = core * 10 + (*p - '0');
+            if (core >= MAX_TRACE_CORES) {
+                return false; // Core ID out of range
+            }
+        }
+        if (p == end || !is_trace_space(*p)) {
+            return false; // Invalid format
+        }
+    }
+    
+    // Read operation token
+    while (p < end && is_trace_space(*p)) p++;
+    const char* op_begin = p;
+    while (p < end && !is_trace_space(*p)) p++;
+    const char* op_end = p;
+    if (op_end == op_begin) {
+        return false; // Invalid format
+    }
+    
+    // Read address token
+    while (p < end && is_trace_space(*p)) p++;
+    const char* addr_end = p;
+    while (addr_end < end && !is_trace_space(*addr_end)) addr_end++;
+    if (addr_end == p) {
+        return false; // Invalid format
+    }
+    
+    // Validate operation
+    if (op_end - op_begin != 1 || (*op_begin != 'r' && *op_begin != 'w' && *op_begin != 'i')) {
+        return false; // Invalid operation
+    }
+    
+    // Parse hexadecimal address (up to 64 bits, 16 hex digits)
+    // Leading zeros may be omitted in trace file (e.g., "ffff" = "0000ffff")
+    bool negative = false;
+    if (*p == '+' || *p == '-') {
+        negative = (*p == '-');
+        p++;
+    }
+    if (addr_end - p >= 3 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X') && hex_digit_value(p[2]) >= 0) {
+        p += 2;
+    }
+    
+    unsigned long address = 0;
+    const char* digits = p;
+    for (; p < addr_end; p++) {
+        int digit = hex_digit_value(*p);
+        if (digit < 0) break;
+        
+        // Validate that address fits in 64 bits
+        if (address >> 60 != 0) {
+            return false; // Address too large for 64-bit
+        }
+        address = (address << 4) | digit;
+    }
+    if (p == digits) {
+        return false; // Invalid address format
+    }
+    if (negative && address != 0) {
+        return false; // Negated value wraps around 64 bits
+    }
+    
+    entry.operation = *op_begin;
+    entry.address = address;
+    entry.core = core;
+    return true;
+}
+
+// Parse a single line from trace file
+bool parse_trace_line(const std::string& line, TraceEntry& entry) {
+    return parse_trace_record(line.data(), line.data() + line.size(), entry);
+}
+
+// Read-only view of a whole trace file. Regular files are memory-mapped so the
+// parser walks the page cache directly; pipes and other streams are read into memory.
+class MappedFile {
+private:
+    const char* data_;
+    size_t size_;
+    bool mapped_;
+    std::vector<char> buffer_;
+    
+public:
+    MappedFile() : data_(nullptr), size_(0), mapped_(false) {}
+    
+    ~MappedFile() {
+        close();
+    }
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    bool open(const std::string& filename) {
+        close();
+        
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+            size_ = static_cast<size_t>(info.st_size);
+            if (size_ > 0) {
+                void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (addr != MAP_FAILED) {
+                    madvise(addr, size_, MADV_SEQUENTIAL);
+                    data_ = static_cast<const char*>(addr);
+                    mapped_ = true;
+                }
+            }
+            if (mapped_ || size_ == 0) {
+                ::close(fd);
+                return true;
+            }
+        }
+        
+        // Not mappable: fall back to reading the stream into memory
+        char chunk[1 << 16];
+        ssize_t n;
+        while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) {
+            buffer_.insert(buffer_.end(), chunk, chunk + n);
+        }
+        ::close(fd);
+        if (n < 0) {
+            buffer_.clear();
+            return false;
+        }
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        return true;
+    }
+    
+    void close() {
+        if (mapped_) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+        buffer_.clear();
+    }
+    
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+};
+
+// Growable array of trivially copyable T backed by an unlinked temporary file and
+// mapped shared, so arrays larger than memory are paged by the kernel instead of
+// exhausting RAM (used for per-access indexes of very long traces)
+template <class T>
+class SpillArray {
+private:
+    std::FILE* file_;
+    T* data_;
+    size_t size_;
+    size_t capacity_;
+    
+    bool remap(size_t capacity) {
+        if (file_ == nullptr) {
+            file_ = std::tmpfile();
+            if (file_ == nullptr) return false;
+        }
+        if (data_ != nullptr) {
+            munmap(data_, capacity_ * sizeof(T));
+            data_ = nullptr;
+        }
+        int fd = fileno(file_);
+        if (ftruncate(fd, static_cast<off_t>(capacity * sizeof(T))) != 0) return false;
+        void* addr = mmap(nullptr, capacity * sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) return false;
+        data_ = static_cast<T*>(addr);
+        capacity_ = capacity;
+        return true;
+    }
+    
+public:
+    SpillArray() : file_(nullptr), data_(nullptr), size_(0), capacity_(0) {}
+    
+    ~SpillArray() {
+        if (data_ != nullptr) {
+            munmap(data_, capacity_ * sizeof(T));
+        }
+        if (file_ != nullptr) {
+            std::fclose(file_);
+        }
+    }
+    
+    SpillArray(const SpillArray&) = delete;
+    SpillArray& operator=(const SpillArray&) = delete;
+    
+    // Fixed size n (contents zeroed)
+    bool resize(size_t n) {
+        if (n > capacity_ && !remap(std::max<size_t>(n, 1))) return false;
+        size_ = n;
+        return true;
+    }
+    
+    bool push_back(const T& value) {
+        if (size_ == capacity_ && !remap(std::max<size_t>(capacity_ * 2, size_t(1) << 16))) return false;
+        data_[size_++] = value;
+        return true;
+    }
+    
+    // Access-pattern hint for the kernel (MADV_SEQUENTIAL, MADV_RANDOM, ...)
+    void advise(int advice) {
+        if (data_ != nullptr) {
+            madvise(data_, capacity_ * sizeof(T), advice);
+        }
+    }
+    
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    size_t size() const { return size_; }
+};
+
+// Fenwick (binary indexed) tree used to count live stack/reuse entries in O(log n)
+class FenwickTree {
+private:
+    std::vector<int> tree;
+    
+public:
+    explicit FenwickTree(size_t n = 0) : tree(n + 1, 0) {}
+    
+    size_t size() const {
+        return tree.size() - 1;
+    }
+    
+    // Clear all counts and resize to n positions
+    void reset(size_t n) {
+        tree.assign(n + 1, 0);
+    }
+    
+    // Add delta at 0-based position index
+    void add(size_t index, int delta) {
+        for (size_t i = index + 1; i < tree.size(); i += i & (~i + 1)) {
+            tree[i] += delta;
+        }
+    }
+    
+    // Sum of positions [0, index]
+    int prefix_sum(size_t index) const {
+        int sum = 0;
+        for (size_t i = index + 1; i > 0; i -= i & (~i + 1)) {
+            sum += tree[i];
+        }
+        return sum;
+    }
+};
+
+// Exact reuse (LRU stack) distance of a key stream: the number of distinct keys touched
+// since the previous access to the same key. Each key's last access is a mark on a
+// timeline; the distance is the count of marks after it. The timeline is compacted to
+// the live keys when it fills, so memory is O(distinct keys) and each access O(log n).
+// Keys are full 64-bit addresses; the last-access index is a flat open-addressing
+// table, so sparse address spaces cost only their touched keys.
+class ReuseDistanceCounter {
+private:
+    static const uint64_t UNSEEN = ~uint64_t(0);
+    
+    FenwickTree marks;
+    std::vector<unsigned long> time_key;         // Key owning each timeline slot
+    BlockPositionTable last_access;              // Key -> timeline slot of its last access
+    size_t next_time;
+    
+    void compact() {
+        std::vector<unsigned long> live;
+        live.reserve(last_access.size());
+        for (size_t t = 0; t < next_time; t++) {
+            if (last_access.find(time_key[t], UNSEEN) == t) {
+                live.push_back(time_key[t]);
+            }
+        }
+        
+        size_t capacity = std::max<size_t>(1024, live.size() * 2);
+        marks.reset(capacity);
+        time_key.assign(capacity, 0);
+        for (size_t t = 0; t < live.size(); t++) {
+            marks.add(t, 1);
+            time_key[t] = live[t];
+            last_access.exchange(live[t], t, UNSEEN);
+        }
+        next_time = live.size();
+    }
+    
+public:
+    static const long COLD = -1;
+    
+    ReuseDistanceCounter() : marks(1024), time_key(1024, 0), last_access(1024), next_time(0) {}
+    
+    // Touch key; returns its reuse distance, or COLD on first access
+    long access(unsigned long key) {
+        if (next_time == marks.size()) {
+            compact();
+        }
+        
+        long distance = COLD;
+        uint64_t previous = last_access.exchange(key, next_time, UNSEEN);
+        if (previous != UNSEEN) {
+            distance = static_cast<long>(last_access.size()) - marks.prefix_sum(previous);
+            marks.add(previous, -1);
+        }
+        
+        marks.add(next_time, 1);
+        time_key[next_time] = key;
+        next_time++;
+        return distance;
+    }
+    
+    // Forget key, as if it had never been accessed
+    void erase(unsigned long key) {
+        uint64_t previous = last_access.find(key, UNSEEN);
+        if (previous != UNSEEN) {
+            marks.add(previous, -1);
+            last_access.erase(key);
+        }
+    }
+    
+    size_t distinct_keys() const {
+        return last_access.size();
+    }
+};
+
+// Performance Analysis Class for comprehensive cache behavior evaluation
+class PerformanceAnalyzer {
+private:
+    struct AccessPattern {
+        std::vector<unsigned long> addresses;
+        std::vector<char> operations;
+        std::vector<double> timestamps;
+        
+        void add_access(unsigned long addr, char op, double time = 0.0) {
+            addresses.push_back(addr);
+            operations.push_back(op);
+            timestamps.push_back(time);
+        }
+        
+        void clear() {
+            addresses.clear();
+            operations.clear();
+            timestamps.clear();
+        }
+    };
+    
+    AccessPattern pattern;
+    
+    // Online accumulators for streaming mode: constant memory apart from the per-set
+    // pollution state, which is bounded by the cache geometry
+    struct StreamingState {
+        static const size_t WINDOW_SIZE = 1000;        // Working-set window (matches batch mode)
+        static const size_t MAX_SAMPLED = 8192;        // Addresses tracked for sampled reuse
+        static const int SKETCH_BITS = 12;             // HyperLogLog registers = 2^SKETCH_BITS
+        
+        // Spatial locality (exact)
+        int block_size;
+        unsigned long prev_address;
+        long prev_stride;
+        unsigned long sequential_count;
+        unsigned long stride_count;
+        unsigned long max_seq_length;
+        unsigned long current_seq_length;
+        double total_stride;
+        
+        // Unique addresses (HyperLogLog estimate)
+        std::vector<uint8_t> sketch;
+        
+        // Reuse distances of a hash-sampled address subset (SHARDS): distances among the
+        // sampled addresses are scaled by the inverse sampling rate. The threshold drops
+        // whenever the subset outgrows MAX_SAMPLED; distances are kept per address and
+        // discarded with it, so the surviving sample is tracked from its first access.
+        struct SampledAddress {
+            double reuse_total;
+            unsigned long reuse_count;
+        };
+        std::unordered_map<unsigned long, SampledAddress> sampled;
+        ReuseDistanceCounter sampled_stack;
+        std::vector<std::pair<uint64_t, unsigned long>> sampled_heap;   // Max-heap on hash
+        uint64_t sample_threshold;
+        
+        // Working set over the most recent WINDOW_SIZE accesses (exact)
+        std::vector<unsigned long> window;
+        std::unordered_map<unsigned long, int> window_counts;
+        
+        // Pollution: per-set access counts and up to associativity + 1 distinct blocks
+        int num_sets;
+        int associativity;
+        std::vector<unsigned long> set_accesses;
+        std::vector<unsigned long> set_blocks;
+        std::vector<int> set_distinct;
+        
+        StreamingState(int bs, int sets, int assoc)
+            : block_size(bs), prev_address(0), prev_stride(0), sequential_count(0), stride_count(0),
+              max_seq_length(1), current_seq_length(1), total_stride(0.0),
+              sketch(size_t(1) << SKETCH_BITS, 0), sample_threshold(UINT64_MAX),
+              window(WINDOW_SIZE, 0),
+              num_sets(sets), associativity(assoc), set_accesses(sets, 0),
+              set_blocks(static_cast<size_t>(sets) * (assoc + 1), 0), set_distinct(sets, 0) {}
+        
+        static uint64_t mix(uint64_t x) {
+            x += 0x9e3779b97f4a7c15ULL;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+            return x ^ (x >> 31);
+        }
+        
+        void record(unsigned long address, uint64_t index) {
+            // Spatial locality, same definitions as analyze_spatial_locality
+            if (index > 0) {
+                long stride = static_cast<long>(address) - static_cast<long>(prev_address);
+                total_stride += std::abs(stride);
+                if (std::abs(stride) <= block_size) {
+                    sequential_count++;
+                    current_seq_length++;
+                } else {
+                    max_seq_length = std::max(max_seq_length, current_seq_length);
+                    current_seq_length = 1;
+                }
+                if (index >= 2 && stride == prev_stride && stride != 0) {
+                    stride_count++;
+                }
+                prev_stride = stride;
+            }
+            prev_address = address;
+            
+            // Unique-address sketch
+            uint64_t hash = mix(address);
+            size_t bucket = hash >> (64 - SKETCH_BITS);
+            uint64_t rest = hash << SKETCH_BITS;
+            uint8_t rank = rest == 0 ? 64 - SKETCH_BITS + 1 : __builtin_clzll(rest) + 1;
+            sketch[bucket] = std::max(sketch[bucket], rank);
+            
+            // Sampled reuse gap
+            if (hash < sample_threshold) {
+                long distance = sampled_stack.access(address);
+                if (distance != ReuseDistanceCounter::COLD) {
+                    SampledAddress& entry = sampled[address];
+                    entry.reuse_total += distance / (std::ldexp(static_cast<double>(sample_threshold), -64));
+                    entry.reuse_count++;
+                } else {
+                    sampled.emplace(address, SampledAddress{0.0, 0});
+                    sampled_heap.emplace_back(hash, address);
+                    std::push_heap(sampled_heap.begin(), sampled_heap.end());
+                    while (sampled.size() > MAX_SAMPLED) {
+                        std::pop_heap(sampled_heap.begin(), sampled_heap.end());
+                        sample_threshold = sampled_heap.back().first;
+                        sampled.erase(sampled_heap.back().second);
+                        sampled_stack.erase(sampled_heap.back().second);
+                        sampled_heap.pop_back();
+                    }
+                }
+            }
+            
+            // Working-set window
+            size_t slot = index % WINDOW_SIZE;
+            if (index >= WINDOW_SIZE) {
+                auto old = window_counts.find(window[slot]);
+                if (--old->second == 0) {
+                    window_counts.erase(old);
+                }
+            }
+            window[slot] = address;
+            window_counts[address]++;
+            
+            // Per-set distinct blocks, saturating once the set holds more than it can fit
+            unsigned long block_addr = address / block_size;
+            int set_index = block_addr % num_sets;
+            set_accesses[set_index]++;
+            int& distinct = set_distinct[set_index];
+            if (distinct <= associativity) {
+                unsigned long* blocks = &set_blocks[static_cast<size_t>(set_index) * (associativity + 1)];
+                if (std::find(blocks, blocks + distinct, block_addr) == blocks + distinct) {
+                    blocks[distinct++] = block_addr;
+                }
+            }
+        }
+        
+        double sampled_reuse_average() const {
+            double total = 0.0;
+            unsigned long count = 0;
+            for (const auto& entry : sampled) {
+                total += entry.second.reuse_total;
+                count += entry.second.reuse_count;
+            }
+            return count > 0 ? total / count : 0.0;
+        }
+        
+        double unique_estimate() const {
+            double m = static_cast<double>(sketch.size());
+            double sum = 0.0;
+            int zeros = 0;
+            for (uint8_t rank : sketch) {
+                sum += std::ldexp(1.0, -rank);
+                zeros += rank == 0;
+            }
+            double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+            if (estimate <= 2.5 * m && zeros > 0) {
+                estimate = m * std::log(m / zeros);   // Linear counting for small cardinalities
+            }
+            return estimate;
+        }
+    };
+    
+    std::unique_ptr<StreamingState> streaming;
+    uint64_t recorded_accesses = 0;
+    bool recording = true;
+    
+public:
+    // Stop recording accesses (quiet runs print no report, so nothing is kept)
+    void disable() {
+        recording = false;
+    }
+    
+    // Compute all metrics online in bounded memory instead of retaining every access.
+    // Pollution is analyzed for the given cache's geometry.
+    template <class CacheType>
+    void enable_streaming(const CacheType& cache) {
+        streaming = std::make_unique<StreamingState>(cache.get_block_size(), cache.get_num_sets(),
+                                                     cache.get_associativity());
+    }
+    
+    bool is_streaming() const {
+        return streaming != nullptr;
+    }
+    
+
+    // Analyze spatial locality in access patterns
+    struct SpatialLocalityStats {
+        double sequential_ratio;        // Ratio of sequential accesses
+        double stride_pattern_ratio;    // Ratio of regular stride patterns
+        double random_access_ratio;     // Ratio of random accesses
+        double avg_stride;              // Average stride distance
+        int max_sequential_length;     // Longest sequential access sequence
+        
+        SpatialLocalityStats() : sequential_ratio(0.0), stride_pattern_ratio(0.0), 
+                               random_access_ratio(0.0), avg_stride(0.0), max_sequential_length(0) {}
+    };
+    
+    // Analyze temporal locality
+    struct TemporalLocalityStats {
+        double reuse_distance_avg;      // Average reuse distance (distinct addresses in between)
+        double block_reuse_distance_avg; // Average reuse distance at block granularity
+        double hit_rate_temporal;       // Hit rate due to temporal locality
+        int unique_addresses;           // Number of unique addresses accessed
+        int unique_blocks;              // Number of unique blocks accessed
+        double working_set_size;        // Estimated working set size
+        
+        // Reuse-distance histograms: bucket 0 holds distance 0, bucket k holds [2^(k-1), 2^k)
+        std::vector<unsigned long> address_reuse_histogram;
+        std::vector<unsigned long> block_reuse_histogram;
+        
+        TemporalLocalityStats() : reuse_distance_avg(0.0), block_reuse_distance_avg(0.0), hit_rate_temporal(0.0), 
+                                unique_addresses(0), unique_blocks(0), working_set_size(0.0) {}
+    };
+    
+    // Histogram bucket of a reuse distance (see TemporalLocalityStats)
+    static size_t reuse_bucket(long distance) {
+        size_t bucket = 0;
+        while (distance > 0) {
+            distance >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+    
+    static void add_to_histogram(std::vector<unsigned long>& histogram, long distance) {
+        size_t bucket = reuse_bucket(distance);
+        if (histogram.size() <= bucket) {
+            histogram.resize(bucket + 1, 0);
+        }
+        histogram[bucket]++;
+    }
+    
+    // Cache pollution analysis
+    struct PollutionStats {
+        double pollution_rate;          // Rate of cache pollution
+        double useful_data_ratio;       // Ratio of useful vs. polluting data
+        int conflict_misses;            // Estimated conflict misses
+        int capacity_misses;            // Estimated capacity misses
+        
+        PollutionStats() : pollution_rate(0.0), useful_data_ratio(0.0), 
+                         conflict_misses(0), capacity_misses(0) {}
+    };
+    
+    // Record access pattern for analysis
+    void record_access(unsigned long address, char operation, double timestamp = 0.0) {
+        if (!recording) {
+            return;
+        }
+        if (streaming) {
+            streaming->record(address, recorded_accesses);
+        } else {
+            pattern.add_access(address, operation, timestamp);
+        }
+        recorded_accesses++;
+    }
+    
+    // Analyze spatial locality
+    SpatialLocalityStats analyze_spatial_locality(int block_size = 32) const {
+        SpatialLocalityStats stats;
+        
+        if (recorded_accesses < 2) return stats;
+        
+        if (streaming) {
+            const StreamingState& state = *streaming;
+            double total_accesses = static_cast<double>(recorded_accesses - 1);
+            stats.sequential_ratio = state.sequential_count / total_accesses;
+            stats.stride_pattern_ratio = state.stride_count / std::max(total_accesses - 1, 1.0);
+            stats.random_access_ratio = 1.0 - stats.sequential_ratio - stats.stride_pattern_ratio;
+            stats.avg_stride = state.total_stride / total_accesses;
+            stats.max_sequential_length = std::max(state.max_seq_length, state.current_seq_length);
+            return stats;
+        }
+        
+        int sequential_count = 0;
+        int stride_count = 0;
+        int max_seq_length = 1;
+        int current_seq_length = 1;
+        long total_stride = 0;
+        
+        // Analyze access patterns
+        for (size_t i = 1; i < pattern.addresses.size(); i++) {
+            long stride = static_cast<long>(pattern.addresses[i]) - static_cast<long>(pattern.addresses[i-1]);
+            total_stride += std::abs(stride);
+            
+            // Check for sequential access (within same block or next block)
+            if (std::abs(stride) <= block_size) {
+                sequential_count++;
+                current_seq_length++;
+            } else {
+                max_seq_length = std::max(max_seq_length, current_seq_length);
+                current_seq_length = 1;
+            }
+            
+            // Check for regular stride patterns
+            if (i >= 2) {
+                long prev_stride = static_cast<long>(pattern.addresses[i-1]) - static_cast<long>(pattern.addresses[i-2]);
+                if (stride == prev_stride && stride != 0) {
+                    stride_count++;
+                }
+            }
+        }
+        
+        max_seq_length = std::max(max_seq_length, current_seq_length);
+        
+        int total_accesses = pattern.addresses.size() - 1;
+        stats.sequential_ratio = (double)sequential_count / total_accesses;
+        stats.stride_pattern_ratio = (double)stride_count / std::max(total_accesses - 1, 1);
+        stats.random_access_ratio = 1.0 - stats.sequential_ratio - stats.stride_pattern_ratio;
+        stats.avg_stride = (double)total_stride / total_accesses;
+        stats.max_sequential_length = max_seq_length;
+        
+        return stats;
+    }
+    
+    // Analyze temporal locality
+    TemporalLocalityStats analyze_temporal_locality(int block_size = 32) const {
+        TemporalLocalityStats stats;
+        
+        if (recorded_accesses == 0) return stats;
+        
+        if (streaming) {
+            const StreamingState& state = *streaming;
+            stats.unique_addresses = static_cast<int>(std::llround(state.unique_estimate()));
+            stats.reuse_distance_avg = state.sampled_reuse_average();
+            stats.working_set_size = state.window_counts.size();
+            return stats;
+        }
+        
+        // Exact reuse distances at byte-address and block granularity in one pass
+        ReuseDistanceCounter address_stack;
+        ReuseDistanceCounter block_stack;
+        double total_address_distance = 0.0, total_block_distance = 0.0;
+        unsigned long address_reuses = 0, block_reuses = 0;
+        
+        for (unsigned long address : pattern.addresses) {
+            long distance = address_stack.access(address);
+            if (distance != ReuseDistanceCounter::COLD) {
+                total_address_distance += distance;
+                address_reuses++;
+                add_to_histogram(stats.address_reuse_histogram, distance);
+            }
+            
+            distance = block_stack.access(address / block_size);
+            if (distance != ReuseDistanceCounter::COLD) {
+                total_block_distance += distance;
+                block_reuses++;
+                add_to_histogram(stats.block_reuse_histogram, distance);
+            }
+        }
+        
+        stats.unique_addresses = address_stack.distinct_keys();
+        stats.unique_blocks = block_stack.distinct_keys();
+        if (address_reuses > 0) {
+            stats.reuse_distance_avg = total_address_distance / address_reuses;
+        }
+        if (block_reuses > 0) {
+            stats.block_reuse_distance_avg = total_block_distance / block_reuses;
+        }
+        
+        // Estimate working set size (unique addresses in recent window)
+        const size_t window_size = std::min((size_t)1000, pattern.addresses.size());
+        std::unordered_set<unsigned long> recent_addresses;
+        
+        for (size_t i = pattern.addresses.size() - window_size; i < pattern.addresses.size(); i++) {
+            recent_addresses.insert(pattern.addresses[i]);
+        }
+        
+        stats.working_set_size = recent_addresses.size();
+        
+        return stats;
+    }
+    
+    // Analyze cache pollution effects
+    template <class CacheType>
+    PollutionStats analyze_cache_pollution(const CacheType& cache) const {
+        PollutionStats stats;
+        
+        if (recorded_accesses == 0) return stats;
+        
+        // Exact counts when the cache classified its misses
+        if (cache.classifies_misses()) {
+            const auto& cache_stats = cache.get_stats();
+            unsigned long accesses = cache_stats.reads + cache_stats.writes;
+            stats.conflict_misses = cache_stats.conflict_misses;
+            stats.capacity_misses = cache_stats.capacity_misses;
+            stats.pollution_rate = accesses > 0 ? (double)cache_stats.conflict_misses / accesses : 0.0;
+            stats.useful_data_ratio = 1.0 - stats.pollution_rate;
+            return stats;
+        }
+        
+        if (streaming) {
+            const StreamingState& state = *streaming;
+            unsigned long total_conflicts = 0;
+            for (int set = 0; set < state.num_sets; set++) {
+                if (state.set_distinct[set] > state.associativity) {
+                    total_conflicts += state.set_accesses[set] - state.associativity;
+                }
+            }
+            stats.pollution_rate = (double)total_conflicts / recorded_accesses;
+            stats.useful_data_ratio = 1.0 - stats.pollution_rate;
+            stats.conflict_misses = total_conflicts;
+            return stats;
+        }
+        
+        // Simulate cache behavior to identify pollution
+        int block_size = cache.get_block_size();
+        int num_sets = cache.get_num_sets();
+        int associativity = cache.get_associativity();
+        
+        // Simple pollution analysis based on set conflicts: per-set access and distinct
+        // block counts, with one flat set of the blocks seen (O(footprint), any address width)
+        std::vector<unsigned long> set_accesses(num_sets, 0);
+        std::vector<unsigned long> set_distinct(num_sets, 0);
+        BlockSet seen;
+        
+        for (unsigned long addr : pattern.addresses) {
+            unsigned long block_addr = addr / block_size;
+            size_t set_index = block_addr % num_sets;
+            set_accesses[set_index]++;
+            if (seen.insert(block_addr)) {
+                set_distinct[set_index]++;
+            }
+        }
+        
+        unsigned long total_conflicts = 0;
+        unsigned long total_accesses = 0;
+        
+        for (int set = 0; set < num_sets; set++) {
+            total_accesses += set_accesses[set];
+            
+            // Count potential conflicts (more unique blocks than associativity)
+            if (set_distinct[set] > (unsigned long)associativity) {
+                total_conflicts += set_accesses[set] - associativity;
+            }
+        }
+        
+        if (total_accesses > 0) {
+            stats.pollution_rate = (double)total_conflicts / total_accesses;
+            stats.useful_data_ratio = 1.0 - stats.pollution_rate;
+        }
+        
+        stats.conflict_misses = total_conflicts;
+        
+        return stats;
+    }
+    
+    // Generate comprehensive performance report
+    template <class CacheType>
+    void generate_performance_report(const CacheType& l1_cache, const CacheType& l2_cache, 
+                                   const std::string& trace_name) const {
+        
+        std::cout << "\n" << std::string(80, '=') << std::endl;
+        std::cout << "COMPREHENSIVE PERFORMANCE ANALYSIS REPORT" << std::endl;
+        std::cout << std::string(80, '=') << std::endl;
+        std::cout << "Trace: " << trace_name << std::endl;
+        std::cout << "Total Accesses: " << recorded_accesses << std::endl;
+        if (streaming) {
+            std::cout << "Analysis Mode: streaming (unique addresses and reuse distance are estimates)" << std::endl;
+        }
+        std::cout << std::endl;
+        
+        // Cache Configuration Analysis
+        std::cout << "CACHE CONFIGURATION ANALYSIS" << std::endl;
+        std::cout << std::string(40, '-') << std::endl;
+        
+        const auto& l1_stats = l1_cache.get_stats();
+        std::cout << "L1 Cache:" << std::endl;
+        std::cout << "  Size: " << l1_cache.get_size() << " bytes" << std::endl;
+        std::cout << "  Associativity: " << l1_cache.get_associativity() << "-way" << std::endl;
+        std::cout << "  Block Size: " << l1_cache.get_block_size() << " bytes" << std::endl;
+        std::cout << "  Area: " << std::fixed << std::setprecision(4) << l1_stats.area_mm2 << " mm²" << std::endl;
+        std::cout << "  AAT: " << std::fixed << std::setprecision(2) << l1_stats.get_aat() << " cycles" << std::endl;
+        std::cout << "  Performance/Area: " << std::scientific << std::setprecision(2) 
+                  << l1_stats.get_performance_per_area() << " (1/cycles)/mm²" << std::endl;
+        
+        if (l2_cache.is_enabled()) {
+            const auto& l2_stats = l2_cache.get_stats();
+            std::cout << "\nL2 Cache:" << std::endl;
+            std::cout << "  Size: " << l2_cache.get_size() << " bytes" << std::endl;
+            std::cout << "  Associativity: " << l2_cache.get_associativity() << "-way" << std::endl;
+            std::cout << "  Area: " << std::fixed << std::setprecision(4) << l2_stats.area_mm2 << " mm²" << std::endl;
+            std::cout << "  AAT: " << std::fixed << std::setprecision(2) << l2_stats.get_aat() << " cycles" << std::endl;
+        }
+        
+        // Spatial Locality Analysis
+        auto spatial_stats = analyze_spatial_locality(l1_cache.get_block_size());
+        std::cout << "\nSPATIAL LOCALITY ANALYSIS" << std::endl;
+        std::cout << std::string(40, '-') << std::endl;
+        std::cout << "Sequential Access Ratio: " << std::fixed << std::setprecision(3) 
+                  << spatial_stats.sequential_ratio << std::endl;
+        std::cout << "Stride Pattern Ratio: " << spatial_stats.stride_pattern_ratio << std::endl;
+        std::cout << "Random Access Ratio: " << spatial_stats.random_access_ratio << std::endl;
+        std::cout << "Average Stride: " << std::fixed << std::setprecision(1) 
+                  << spatial_stats.avg_stride << " bytes" << std::endl;
+        std::cout << "Max Sequential Length: " << spatial_stats.max_sequential_length << " accesses" << std::endl;
+        
+        // Temporal Locality Analysis
+        auto temporal_stats = analyze_temporal_locality(l1_cache.get_block_size());
+        std::cout << "\nTEMPORAL LOCALITY ANALYSIS" << std::endl;
+        std::cout << std::string(40, '-') << std::endl;
+        std::cout << "Unique Addresses: " << temporal_stats.unique_addresses << std::endl;
+        std::cout << "Working Set Size: " << temporal_stats.working_set_size << " addresses" << std::endl;
+        std::cout << "Average Reuse Distance: " << std::fixed << std::setprecision(1) 
+                  << temporal_stats.reuse_distance_avg << " distinct addresses" << std::endl;
+        if (!streaming) {
+            std::cout << "Unique Blocks: " << temporal_stats.unique_blocks << std::endl;
+            std::cout << "Average Block Reuse Distance: " << std::fixed << std::setprecision(1)
+                      << temporal_stats.block_reuse_distance_avg << " distinct blocks" << std::endl;
+            
+            const auto& by_address = temporal_stats.address_reuse_histogram;
+            const auto& by_block = temporal_stats.block_reuse_histogram;
+            size_t buckets = std::max(by_address.size(), by_block.size());
+            char fill = std::cout.fill(' ');
+            if (buckets > 0) {
+                std::cout << "Reuse Distance Histogram:" << std::endl;
+                std::cout << "  " << std::setw(23) << "distance" << std::setw(14) << "addresses"
+                          << std::setw(14) << "blocks" << std::endl;
+            }
+            for (size_t bucket = 0; bucket < buckets; bucket++) {
+                unsigned long low = bucket == 0 ? 0 : 1UL << (bucket - 1);
+                unsigned long high = bucket == 0 ? 1 : 1UL << bucket;
+                std::ostringstream range;
+                range << "[" << low << ", " << high << ")";
+                std::cout << "  " << std::setw(23) << range.str()
+                          << std::setw(14) << (bucket < by_address.size() ? by_address[bucket] : 0)
+                          << std::setw(14) << (bucket < by_block.size() ? by_block[bucket] : 0) << std::endl;
+            }
+            std::cout.fill(fill);
+        }
+        
+        // Cache Pollution Analysis
+        auto pollution_stats = analyze_cache_pollution(l1_cache);
+        std::cout << "\nCACHE POLLUTION ANALYSIS" << std::endl;
+        std::cout << std::string(40, '-') << std::endl;
+        std::cout << "Pollution Rate: " << std::fixed << std::setprecision(3) 
+                  << pollution_stats.pollution_rate << std::endl;
+        std::cout << "Useful Data Ratio: " << pollution_stats.useful_data_ratio << std::endl;
+        if (l1_cache.classifies_misses()) {
+            std::cout << "Conflict Misses (3C): " << pollution_stats.conflict_misses << std::endl;
+            std::cout << "Capacity Misses (3C): " << pollution_stats.capacity_misses << std::endl;
+        } else {
+            std::cout << "Estimated Conflict Misses: " << pollution_stats.conflict_misses << std::endl;
+        }
+        
+        // Performance Trade-offs
+        std::cout << "\nPERFORMANCE TRADE-OFFS" << std::endl;
+        std::cout << std::string(40, '-') << std::endl;
+        std::cout << "Miss Rate vs. Area Trade-off:" << std::endl;
+        std::cout << "  Miss Rate: " << std::fixed << std::setprecision(3) 
+                  << l1_stats.get_overall_miss_rate() << std::endl;
+        std::cout << "  Area Cost: " << l1_stats.area_mm2 << " mm²" << std::endl;
+        std::cout << "  Performance Efficiency: " << std::scientific << std::setprecision(2) 
+                  << (1.0 - l1_stats.get_overall_miss_rate()) / l1_stats.area_mm2 << " hit_rate/mm²" << std::endl;
+        
+        std::cout << std::endl;
+    }
+    
+    // Clear recorded access patterns
+    void clear() {
+        pattern.clear();
+        if (streaming) {
+            streaming = std::make_unique<StreamingState>(streaming->block_size, streaming->num_sets,
+                                                         streaming->associativity);
+        }
+        recorded_accesses = 0;
+    }
+};
+
+// Mattson stack-distance engine: one pass per set count yields the LRU miss ratio of
+// every associativity sharing that set count (LRU inclusion property).
+class StackDistanceAnalyzer {
+private:
+    // Recency stack of a single set, stored as marks on a local timeline.
+    // A mark at time t means the block last touched at t is still on the stack;
+    // the stack distance of a re-reference is the number of marks after its last touch.
+    struct SetStack {
+        FenwickTree marks;
+        std::vector<unsigned long> time_block;   // Block address owning each timeline slot
+        size_t next_time;
+        size_t live_blocks;
+        
+        SetStack() : next_time(0), live_blocks(0) {}
+    };
+    
+    struct SetCountProfile {
+        int num_sets;
+        int max_distance;                        // Distances >= this are misses for every tracked assoc
+        std::vector<SetStack> sets;
+        BlockPositionTable last_access;          // Block -> local time in its set
+        std::vector<unsigned long> read_histogram;   // [max_distance] = beyond max or cold
+        std::vector<unsigned long> write_histogram;
+    };
+    
+    int block_size;
+    std::vector<SetCountProfile> profiles;
+    unsigned long reads;
+    unsigned long writes;
+    
+    // Renumber the live marks of a set to 0..k-1 so its timeline stays O(distinct blocks)
+    static const uint64_t UNSEEN = ~uint64_t(0);
+    
+    static void compact(SetStack& stack, BlockPositionTable& last_access) {
+        std::vector<unsigned long> live;
+        live.reserve(stack.live_blocks);
+        for (size_t t = 0; t < stack.next_time; t++) {
+            if (last_access.find(stack.time_block[t], UNSEEN) == t) {
+                live.push_back(stack.time_block[t]);
+            }
+        }
+        
+        size_t capacity = std::max<size_t>(64, live.size() * 2);
+        stack.marks.reset(capacity);
+        stack.time_block.assign(capacity, 0);
+        for (size_t t = 0; t < live.size(); t++) {
+            stack.marks.add(t, 1);
+            stack.time_block[t] = live[t];
+            last_access.exchange(live[t], t, UNSEEN);
+        }
+        stack.next_time = live.size();
+    }
+    
+public:
+    // set_counts[i] is tracked for associativities up to max_assocs[i]
+    StackDistanceAnalyzer(int bs, const std::vector<int>& set_counts, const std::vector<int>& max_assocs)
+        : block_size(bs), reads(0), writes(0) {
+        for (size_t i = 0; i < set_counts.size(); i++) {
+            SetCountProfile profile;
+            profile.num_sets = set_counts[i];
+            profile.max_distance = max_assocs[i];
+            profile.sets.resize(set_counts[i]);
+            profile.read_histogram.assign(max_assocs[i] + 1, 0);
+            profile.write_histogram.assign(max_assocs[i] + 1, 0);
+            profiles.push_back(std::move(profile));
+        }
+    }
+    
+    // Push one access through the recency stack of every tracked set count
+    void record_access(unsigned long address, bool is_write) {
+        unsigned long block_addr = address / block_size;
+        if (is_write) {
+            writes++;
+        } else {
+            reads++;
+        }
+        
+        for (auto& profile : profiles) {
+            SetStack& stack = profile.sets[block_addr % profile.num_sets];
+            auto& histogram = is_write ? profile.write_histogram : profile.read_histogram;
+            
+            if (stack.next_time == stack.marks.size()) {
+                compact(stack, profile.last_access);
+            }
+            
+            uint64_t previous = profile.last_access.exchange(block_addr, stack.next_time, UNSEEN);
+            if (previous == UNSEEN) {
+                // Cold miss: block enters the stack for the first time
+                histogram[profile.max_distance]++;
+                stack.live_blocks++;
+            } else {
+                // Marks strictly newer than the previous touch are the distinct blocks in between
+                size_t distance = stack.live_blocks - stack.marks.prefix_sum(previous);
+                histogram[std::min<size_t>(distance, profile.max_distance)]++;
+                stack.marks.add(previous, -1);
+            }
+            
+            stack.marks.add(stack.next_time, 1);
+            stack.time_block[stack.next_time] = block_addr;
+            stack.next_time++;
+        }
+    }
+    
+    // LRU statistics of a cache with the given geometry, as Cache::access_with_stats would count them
+    Cache::CacheStats get_stats(int num_sets, int associativity) const {
+        Cache::CacheStats stats;
+        for (const auto& profile : profiles) {
+            if (profile.num_sets != num_sets || associativity > profile.max_distance) continue;
+            
+            unsigned long read_hits = 0, write_hits = 0;
+            for (int d = 0; d < associativity; d++) {
+                read_hits += profile.read_histogram[d];
+                write_hits += profile.write_histogram[d];
+            }
+            stats.reads = reads;
+            stats.writes = writes;
+            stats.read_hits = read_hits;
+            stats.write_hits = write_hits;
+            stats.read_misses = reads - read_hits;
+            stats.write_misses = writes - write_hits;
+            break;
+        }
+        return stats;
+    }
+    
+    int get_block_size() const { return block_size; }
+};
+
+// Parse every line of [data, data + size), continuing the numbering in line_number.
+// A final segment without a trailing newline is treated as a complete line.
+template <typename Callback>
+void scan_trace_lines(const char* data, size_t size, uint64_t& line_number, Callback& callback) {
+    const char* end = data + size;
+    const char* line_begin = data;
+    
+    while (line_begin < end) {
+        const char* newline = static_cast<const char*>(memchr(line_begin, '\n', end - line_begin));
+        const char* line_end = newline != nullptr ? newline : end;
+        line_number++;
+        
+        // Skip empty lines and comments
+        if (line_end != line_begin && *line_begin != '#') {
+            std::string_view line(line_begin, line_end - line_begin);
+            TraceEntry entry('r', 0);
+            if (parse_trace_record(line_begin, line_end, entry)) {
+                callback(entry, line_number, line);
+            } else {
+                std::cerr << "Warning: Invalid trace format at line " << line_number 
+                          << ": '" << line << "'" << std::endl;
+            }
+        }
+        
+        line_begin = line_end + 1;
+    }
+}
+
+// Walk every valid access in a trace buffer, invoking callback(entry, line_number, line).
+// Comments, empty lines and malformed lines are handled here so that every
+// simulation mode sees exactly the same access sequence.
+template <typename Callback>
+void for_each_trace_entry(const char* data, size_t size, Callback&& callback) {
+    uint64_t line_number = 0;
+    scan_trace_lines(data, size, line_number, callback);
+}
+
+// Binary trace format: a fixed header followed by one variable-length record per access.
+// Each record stores the zigzag-encoded delta from the previous address with the
+// operation folded into bit 0 of the first byte:
+//   byte 0:  [continue:1][delta bits 0-5:6][is_write:1]
+//   byte k:  [continue:1][next 7 delta bits:7]      (LEB128)
+// Sequential and strided traces need 1-2 bytes per access instead of 11+ as text.
+const char BINARY_TRACE_MAGIC[8] = {'C', 'S', 'I', 'M', 'T', 'R', 'C', '\0'};
+const uint32_t BINARY_TRACE_VERSION = 1;
+const uint32_t BINARY_TRACE_DELTA_VARINT = 1;
+
+struct BinaryTraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t encoding;
+    uint64_t record_count;     // Host byte order (little-endian on supported hosts)
+};
+
+inline bool is_binary_trace(const char* data, size_t size) {
+    return size >= sizeof(BinaryTraceHeader) &&
+           memcmp(data, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC)) == 0;
+}
+
+// Append one encoded record to out; returns the number of bytes written (at most 11)
+inline size_t encode_binary_record(unsigned long address, bool is_write,
+                                   unsigned long previous, unsigned char* out) {
+    int64_t delta = static_cast<int64_t>(address - previous);
+    uint64_t zigzag = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+    
+    size_t n = 0;
+    unsigned char byte = static_cast<unsigned char>(((zigzag & 0x3F) << 1) | (is_write ? 1 : 0));
+    zigzag >>= 6;
+    while (zigzag != 0) {
+        out[n++] = byte | 0x80;
+        byte = static_cast<unsigned char>(zigzag & 0x7F);
+        zigzag >>= 7;
+    }
+    out[n++] = byte;
+    return n;
+}
+
+// Incremental decoder for the records that follow a binary trace header.
+// Records may be fed in arbitrary pieces; decode() stops before an incomplete record.
+class BinaryTraceDecoder {
+private:
+    unsigned long address;
+    uint64_t record;
+    uint64_t record_count;
+    
+public:
+    explicit BinaryTraceDecoder(uint64_t count) : address(0), record(0), record_count(count) {}
+    
+    static bool check_header(const BinaryTraceHeader& header) {
+        if (header.version != BINARY_TRACE_VERSION || header.encoding != BINARY_TRACE_DELTA_VARINT) {
+            std::cerr << "Error: Unsupported binary trace version " << header.version
+                      << " (encoding " << header.encoding << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    // Decode complete records from [p, end), invoking callback(entry, record_number, "").
+    // Returns a pointer to the first byte not consumed.
+    template <typename Callback>
+    const unsigned char* decode(const unsigned char* p, const unsigned char* end, Callback& callback) {
+        while (record < record_count && p < end) {
+            const unsigned char* start = p;
+            unsigned char byte = *p++;
+            bool is_write = byte & 1;
+            uint64_t zigzag = (byte >> 1) & 0x3F;
+            int shift = 6;
+            while ((byte & 0x80) && p < end) {
+                byte = *p++;
+                if (shift < 64) {
+                    zigzag |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                }
+                shift += 7;
+            }
+            if (byte & 0x80) {
+                return start; // Incomplete record
+            }
+            
+            int64_t delta = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+            address += static_cast<unsigned long>(delta);
+            record++;
+            callback(TraceEntry(is_write ? 'w' : 'r', address), record, std::string_view());
+        }
+        return p;
+    }
+    
+    // Warn when the stream ended before the header's record count was reached
+    void finish() const {
+        if (record != record_count) {
+            std::cerr << "Warning: Binary trace truncated after " << record << " of "
+                      << record_count << " records" << std::endl;
+        }
+    }
+};
+
+// Walk every record of a binary trace, invoking callback(entry, record_number, "")
+template <typename Callback>
+bool for_each_binary_trace_entry(const char* data, size_t size, Callback&& callback) {
+    BinaryTraceHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (!BinaryTraceDecoder::check_header(header)) {
+        return false;
+    }
+    
+    BinaryTraceDecoder decoder(header.record_count);
+    decoder.decode(reinterpret_cast<const unsigned char*>(data) + sizeof(header),
+                   reinterpret_cast<const unsigned char*>(data) + size, callback);
+    decoder.finish();
+    return true;
+}
+
+// Streaming decompression of gzip/zstd/xz traces. A background thread inflates the
+// mapped compressed file into fixed-size chunks handed to the parser through a
+// bounded queue, so decoding overlaps with simulation and nothing touches disk.
+class CompressedTraceReader {
+public:
+    enum Format { NONE, GZIP, ZSTD, XZ };
+    
+private:
+    static const size_t CHUNK_SIZE = 1 << 20;
+    static const size_t MAX_QUEUED_CHUNKS = 4;
+    
+    const unsigned char* input;
+    size_t input_size;
+    Format format;
+    
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<std::vector<char>> filled;
+    std::vector<std::vector<char>> free_chunks;
+    bool finished;
+    bool stopping;
+    std::string error;
+    
+    // Producer side: queue chunk[0, produced) and continue with an empty chunk.
+    // Blocks while the queue is full; returns false if the consumer has gone away.
+    bool publish(std::vector<char>& chunk, size_t produced) {
+        chunk.resize(produced);
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return filled.size() < MAX_QUEUED_CHUNKS || stopping; });
+        if (stopping) return false;
+        filled.push_back(std::move(chunk));
+        not_empty.notify_one();
+        
+        if (!free_chunks.empty()) {
+            chunk = std::move(free_chunks.back());
+            free_chunks.pop_back();
+        } else {
+            chunk = std::vector<char>();
+        }
+        chunk.resize(CHUNK_SIZE);
+        return true;
+    }
+    
+    void run() {
+        std::vector<char> chunk(CHUNK_SIZE);
+        size_t fill = 0;
+        std::string message;
+        
+        switch (format) {
+#ifdef HAVE_ZLIB
+            case GZIP: message = inflate_gzip(chunk, fill); break;
+#endif
+#ifdef HAVE_ZSTD
+            case ZSTD: message = inflate_zstd(chunk, fill); break;
+#endif
+#ifdef HAVE_LZMA
+            case XZ: message = inflate_xz(chunk, fill); break;
+#endif
+            default: message = "This build has no decoder for the trace's compression format"; break;
+        }
+        
+        // Publish the final partial chunk, then signal end of stream
+        if (fill > 0) {
+            publish(chunk, fill);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        error = message;
+        finished = true;
+        not_empty.notify_one();
+    }
+    
+    // Each decoder writes into chunk[fill, CHUNK_SIZE), publishing whenever the chunk
+    // fills up, and returns an error message (empty on success).
+#ifdef HAVE_ZLIB
+    std::string inflate_gzip(std::vector<char>& chunk, size_t& fill) {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if (inflateInit2(&zs, 15 + 32) != Z_OK) {  // +32: accept gzip or zlib headers
+            return "Cannot initialize gzip decoder";
+        }
+        
+        size_t offset = 0;
+        std::string message;
+        while (true) {
+            // zlib counts input in 32-bit units; feed large files in windows
+            if (zs.avail_in == 0 && offset < input_size) {
+                size_t window = std::min<size_t>(input_size - offset, 1u << 30);
+                zs.next_in = const_cast<Bytef*>(input + offset);
+                zs.avail_in = static_cast<uInt>(window);
+                offset += window;
+            }
+            
+            zs.next_out = reinterpret_cast<Bytef*>(chunk.data() + fill);
+            zs.avail_out = static_cast<uInt>(CHUNK_SIZE - fill);
+            int ret = inflate(&zs, Z_NO_FLUSH);
+            fill = CHUNK_SIZE - zs.avail_out;
+            if (fill == CHUNK_SIZE) {
+                if (!publish(chunk, fill)) break;
+                fill = 0;
+            }
+            
+            bool input_done = (zs.avail_in == 0 && offset >= input_size);
+            if (ret == Z_STREAM_END) {
+                if (input_done) break;
+                inflateReset(&zs);  // Concatenated gzip members
+            } else if (ret == Z_BUF_ERROR) {
+                if (input_done) {
+                    message = "Truncated gzip trace data";
+                    break;
+                }
+            } else if (ret != Z_OK) {
+                message = "Corrupt gzip trace data";
+                break;
+            }
+        }
+        
+        inflateEnd(&zs);
+        return message;
+    }
+#endif
+    
+#ifdef HAVE_ZSTD
+    std::string inflate_zstd(std::vector<char>& chunk, size_t& fill) {
+        ZSTD_DStream* stream = ZSTD_createDStream();
+        if (stream == nullptr || ZSTD_isError(ZSTD_initDStream(stream))) {
+            ZSTD_freeDStream(stream);
+            return "Cannot initialize zstd decoder";
+        }
+        
+        ZSTD_inBuffer in = {input, input_size, 0};
+        size_t pending = 1;      // Non-zero while a frame is incomplete
+        bool output_full = false;
+        std::string message;
+        while (in.pos < in.size || output_full) {
+            ZSTD_outBuffer out = {chunk.data() + fill, CHUNK_SIZE - fill, 0};
+            pending = ZSTD_decompressStream(stream, &out, &in);
+            if (ZSTD_isError(pending)) {
+                message = std::string("Corrupt zstd trace data: ") + ZSTD_getErrorName(pending);
+                break;
+            }
+            fill += out.pos;
+            output_full = (out.pos == out.size);
+            if (fill == CHUNK_SIZE) {
+                if (!publish(chunk, fill)) break;
+                fill = 0;
+            }
+        }
+        if (message.empty() && pending != 0) {
+            message = "Truncated zstd trace data";
+        }
+        
+        ZSTD_freeDStream(stream);
+        return message;
+    }
+#endif
+    
+#ifdef HAVE_LZMA
+    std::string inflate_xz(std::vector<char>& chunk, size_t& fill) {
+        lzma_stream stream = LZMA_STREAM_INIT;
+        if (lzma_stream_decoder(&stream, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+            return "Cannot initialize xz decoder";
+        }
+        
+        stream.next_in = input;
+        stream.avail_in = input_size;
+        std::string message;
+        while (true) {
+            stream.next_out = reinterpret_cast<uint8_t*>(chunk.data() + fill);
+            stream.avail_out = CHUNK_SIZE - fill;
+            lzma_ret ret = lzma_code(&stream, stream.avail_in == 0 ? LZMA_FINISH : LZMA_RUN);
+            fill = CHUNK_SIZE - stream.avail_out;
+            if (fill == CHUNK_SIZE) {
+                if (!publish(chunk, fill)) break;
+                fill = 0;
+            }
+            
+            if (ret == LZMA_STREAM_END) break;
+            if (ret == LZMA_BUF_ERROR) {
+                message = "Truncated xz trace data";
+                break;
+            }
+            if (ret != LZMA_OK) {
+                message = "Corrupt xz trace data";
+                break;
+            }
+        }
+        
+        lzma_end(&stream);
+        return message;
+    }
+#endif
+    
+public:
+    CompressedTraceReader(const char* data, size_t size, Format fmt)
+        : input(reinterpret_cast<const unsigned char*>(data)), input_size(size), format(fmt),
+          finished(false), stopping(false) {
+        worker = std::thread(&CompressedTraceReader::run, this);
+    }
+    
+    ~CompressedTraceReader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            not_full.notify_all();
+        }
+        worker.join();
+    }
+    
+    // Identify the compression format from the stream's magic bytes
+    static Format detect(const char* data, size_t size) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+        if (size >= 2 && p[0] == 0x1F && p[1] == 0x8B) return GZIP;
+        if (size >= 4 && p[0] == 0x28 && p[1] == 0xB5 && p[2] == 0x2F && p[3] == 0xFD) return ZSTD;
+        if (size >= 6 && p[0] == 0xFD && p[1] == '7' && p[2] == 'z' && p[3] == 'X' && p[4] == 'Z' && p[5] == 0) return XZ;
+        return NONE;
+    }
+    
+    // Consumer side: wait for the next decompressed chunk; false at end of stream
+    bool next_chunk(std::vector<char>& chunk) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!chunk.empty() || chunk.capacity() > 0) {
+            free_chunks.push_back(std::move(chunk));
+        }
+        not_empty.wait(lock, [this] { return !filled.empty() || finished; });
+        if (filled.empty()) {
+            return false;
+        }
+        chunk = std::move(filled.front());
+        filled.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+    
+    // Set once the stream has been fully consumed; empty on success
+    std::string get_error() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return error;
+    }
+};
+
+// Parse a decompressed trace stream chunk by chunk. Lines (text) or records (binary)
+// that straddle a chunk boundary are carried over into the next chunk.
+template <typename Callback>
+bool for_each_compressed_trace_entry(const MappedFile& file, CompressedTraceReader::Format format,
+                                     Callback& callback) {
+    CompressedTraceReader reader(file.data(), file.size(), format);
+    std::vector<char> chunk;
+    std::string head;      // Start of the stream, buffered until its format is known
+    std::string carry;     // Partial line or record continued by the next chunk
+    uint64_t line_number = 0;
+    bool started = false;
+    bool binary = false;
+    std::unique_ptr<BinaryTraceDecoder> decoder;
+    
+    while (reader.next_chunk(chunk)) {
+        const char* p = chunk.data();
+        const char* end = p + chunk.size();
+        
+        // The decompressed stream may itself be a binary trace
+        if (!started) {
+            head.append(p, end);
+            if (head.size() < sizeof(BinaryTraceHeader)) continue;
+            started = true;
+            binary = is_binary_trace(head.data(), head.size());
+            if (binary) {
+                BinaryTraceHeader header;
+                memcpy(&header, head.data(), sizeof(header));
+                if (!BinaryTraceDecoder::check_header(header)) return false;
+                decoder = std::make_unique<BinaryTraceDecoder>(header.record_count);
+                head.erase(0, sizeof(header));
+            }
+            p = head.data();
+            end = p + head.size();
+        }
+        
+        if (binary) {
+            // Complete the record carried from the previous chunk, then decode in place
+            if (!carry.empty()) {
+                size_t taken = std::min<size_t>(end - p, 16);
+                size_t before = carry.size();
+                carry.append(p, p + taken);
+                const unsigned char* begin = reinterpret_cast<const unsigned char*>(carry.data());
+                const unsigned char* rest = decoder->decode(begin, begin + carry.size(), callback);
+                size_t used = rest - begin;
+                if (used < before) {
+                    carry.resize(before + taken);  // Still incomplete (chunk smaller than a record)
+                    carry.erase(0, used);
+                    continue;
+                }
+                p += used - before;
+                carry.clear();
+            }
+            const unsigned char* rest = decoder->decode(reinterpret_cast<const unsigned char*>(p),
+                                                        reinterpret_cast<const unsigned char*>(end), callback);
+            carry.assign(reinterpret_cast<const char*>(rest), end);
+        } else {
+            // Finish the line carried from the previous chunk
+            if (!carry.empty()) {
+                const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+                if (newline == nullptr) {
+                    carry.append(p, end);
+                    continue;
+                }
+                carry.append(p, newline);
+                scan_trace_lines(carry.data(), carry.size(), line_number, callback);
+                carry.clear();
+                p = newline + 1;
+            }
+            const char* last_newline = static_cast<const char*>(memrchr(p, '\n', end - p));
+            if (last_newline != nullptr) {
+                scan_trace_lines(p, last_newline + 1 - p, line_number, callback);
+                carry.assign(last_newline + 1, end);
+            } else {
+                carry.assign(p, end);
+            }
+        }
+    }
+    
+    // Streams shorter than a binary header can only be text
+    if (!started) {
+        carry.swap(head);
+    }
+    if (binary) {
+        decoder->finish();
+    } else if (!carry.empty()) {
+        scan_trace_lines(carry.data(), carry.size(), line_number, callback);
+    }
+    
+    std::string error = reader.get_error();
+    if (!error.empty()) {
+        std::cerr << "Error: " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Decoded trace index (--trace-cache): a sidecar "<trace>.didx" holding every access
+// of a trace already parsed, so later runs map it read-only instead of decoding the
+// trace again and concurrent runs share its pages through the page cache. Layout:
+//   DecodedTraceHeader
+//   uint32_t address[record_count]           (padded to 8 bytes; uint64_t with DECODED_TRACE_WIDE)
+//   uint64_t write_bits[(record_count + 63) / 64]
+//   uint64_t fetch_bits[(record_count + 63) / 64]
+//   uint16_t core[record_count]              (only with DECODED_TRACE_CORES)
+// The source's size and modification time are recorded; a sidecar that no longer
+// matches them is rebuilt.
+const char DECODED_TRACE_MAGIC[8] = {'C', 'S', 'I', 'M', 'D', 'T', 'I', '\0'};
+const uint32_t DECODED_TRACE_VERSION = 2;
+const uint32_t DECODED_TRACE_CORES = 1;      // Some record has a non-zero core tag
+const uint32_t DECODED_TRACE_WIDE = 2;       // Some address needs more than 32 bits
+const int DECODED_TRACE_BLOCK_BITS = 16;     // Unique-block counts for 1..32768-byte blocks
+
+struct DecodedTraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t source_size;
+    int64_t source_mtime_ns;
+    uint64_t record_count;
+    uint64_t reads;                          // Summary of the trace (fetches count separately)
+    uint64_t writes;
+    uint64_t fetches;
+    uint64_t min_address;
+    uint64_t max_address;
+    uint64_t unique_blocks[DECODED_TRACE_BLOCK_BITS];   // Distinct address >> k; footprint << k
+};
+
+// Byte offsets of the arrays that follow the header
+struct DecodedTraceLayout {
+    size_t addresses, write_bits, fetch_bits, cores, size;
+    
+    DecodedTraceLayout(uint64_t records, uint32_t flags) {
+        size_t words = (records + 63) / 64;
+        size_t address_bytes = (flags & DECODED_TRACE_WIDE) ? sizeof(uint64_t) : sizeof(uint32_t);
+        bool cores_present = flags & DECODED_TRACE_CORES;
+        addresses = sizeof(DecodedTraceHeader);
+        write_bits = addresses + (records * address_bytes + 7) / 8 * 8;
+        fetch_bits = write_bits + words * sizeof(uint64_t);
+        cores = fetch_bits + words * sizeof(uint64_t);
+        size = cores + (cores_present ? records * sizeof(uint16_t) : 0);
+    }
+};
+
+inline bool is_decoded_trace(const char* data, size_t size) {
+    return size >= sizeof(DecodedTraceHeader) &&
+           memcmp(data, DECODED_TRACE_MAGIC, sizeof(DECODED_TRACE_MAGIC)) == 0;
+}
+
+// Walk every record of a decoded trace index, invoking callback(entry, record_number, "")
+template <typename Callback>
+bool for_each_decoded_trace_entry(const char* data, size_t size, Callback&& callback) {
+    DecodedTraceHeader header;
+    memcpy(&header, data, sizeof(header));
+    DecodedTraceLayout layout(header.record_count, header.flags);
+    if (header.version != DECODED_TRACE_VERSION || layout.size != size) {
+        std::cerr << "Error: Corrupt or unsupported decoded trace index (version " << header.version
+                  << ")" << std::endl;
+        return false;
+    }
+    
+    const uint32_t* addresses = reinterpret_cast<const uint32_t*>(data + layout.addresses);
+    const uint64_t* wide_addresses = reinterpret_cast<const uint64_t*>(data + layout.addresses);
+    bool wide = header.flags & DECODED_TRACE_WIDE;
+    const uint64_t* write_bits = reinterpret_cast<const uint64_t*>(data + layout.write_bits);
+    const uint64_t* fetch_bits = reinterpret_cast<const uint64_t*>(data + layout.fetch_bits);
+    const uint16_t* cores = (header.flags & DECODED_TRACE_CORES)
+        ? reinterpret_cast<const uint16_t*>(data + layout.cores) : nullptr;
+    for (uint64_t i = 0; i < header.record_count; i++) {
+        uint64_t bit = uint64_t(1) << (i & 63);
+        char operation = (write_bits[i >> 6] & bit) ? 'w' : (fetch_bits[i >> 6] & bit) ? 'i' : 'r';
+        unsigned long address = wide ? wide_addresses[i] : addresses[i];
+        callback(TraceEntry(operation, address, cores != nullptr ? cores[i] : 0),
+                 i + 1, std::string_view());
+    }
+    return true;
+}
+
+// Walk a trace file in whichever format it is stored (detected from the header):
+// text, binary, either of those compressed with gzip/zstd/xz, or a decoded trace index
+template <typename Callback>
+bool for_each_trace_file_entry(const MappedFile& file, Callback&& callback) {
+    CompressedTraceReader::Format format = CompressedTraceReader::detect(file.data(), file.size());
+    if (is_decoded_trace(file.data(), file.size())) {
+        return for_each_decoded_trace_entry(file.data(), file.size(), callback);
+    }
+    if (format != CompressedTraceReader::NONE) {
+        return for_each_compressed_trace_entry(file, format, callback);
+    }
+    if (is_binary_trace(file.data(), file.size())) {
+        return for_each_binary_trace_entry(file.data(), file.size(), callback);
+    }
+    for_each_trace_entry(file.data(), file.size(), callback);
+    return true;
+}
+
+// Set by --trace-cache (accepted by every mode): trace files are opened through their
+// decoded index, which is built on first use
+inline bool trace_cache_enabled = false;
+
+inline std::string decoded_trace_path(const std::string& trace_file) {
+    return trace_file + ".didx";
+}
+
+// Parse trace_file once and write its decoded index to sidecar (through a temporary
+// file renamed into place, so concurrent runs never map a partial index)
+bool build_decoded_trace(const std::string& trace_file, const struct stat& source, const std::string& sidecar) {
+    MappedFile file;
+    if (!file.open(trace_file)) {
+        std::cerr << "Error: Cannot open trace file '" << trace_file << "'" << std::endl;
+        return false;
+    }
+    std::string temporary = sidecar + ".tmp." + std::to_string(getpid());
+    std::fstream out(temporary, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Warning: Cannot write decoded trace index '" << temporary << "'" << std::endl;
+        return false;
+    }
+    
+    DecodedTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DECODED_TRACE_MAGIC, sizeof(header.magic));
+    header.version = DECODED_TRACE_VERSION;
+    header.source_size = static_cast<uint64_t>(source.st_size);
+    header.source_mtime_ns = static_cast<int64_t>(source.st_mtim.tv_sec) * 1000000000 + source.st_mtim.tv_nsec;
+    header.min_address = ~uint64_t(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header)); // Rewritten once counted
+    
+    // Addresses go straight to the file, 32 bits wide until the first one that does
+    // not fit; the bit and core arrays follow them, so they wait in spill arrays
+    uint64_t pending[4096];
+    size_t pending_count = 0;
+    uint64_t written = 0;
+    auto flush = [&]() {
+        if (header.flags & DECODED_TRACE_WIDE) {
+            out.write(reinterpret_cast<const char*>(pending), pending_count * sizeof(uint64_t));
+        } else {
+            uint32_t narrow[4096];
+            for (size_t j = 0; j < pending_count; j++) {
+                narrow[j] = static_cast<uint32_t>(pending[j]);
+            }
+            out.write(reinterpret_cast<const char*>(narrow), pending_count * sizeof(uint32_t));
+        }
+        written += pending_count;
+        pending_count = 0;
+    };
+    // Rewrite the addresses written so far at 64 bits, last chunk first so no
+    // narrow address is overwritten before it is read
+    auto widen = [&]() {
+        uint32_t narrow[4096];
+        uint64_t wide[4096];
+        for (uint64_t end = written; end > 0 && out;) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(4096, end));
+            uint64_t start = end - n;
+            out.seekg(static_cast<std::streamoff>(sizeof(header) + start * sizeof(uint32_t)));
+            out.read(reinterpret_cast<char*>(narrow), n * sizeof(uint32_t));
+            for (size_t j = 0; j < n; j++) {
+                wide[j] = narrow[j];
+            }
+            out.seekp(static_cast<std::streamoff>(sizeof(header) + start * sizeof(uint64_t)));
+            out.write(reinterpret_cast<const char*>(wide), n * sizeof(uint64_t));
+            end = start;
+        }
+        out.seekp(static_cast<std::streamoff>(sizeof(header) + written * sizeof(uint64_t)));
+        header.flags |= DECODED_TRACE_WIDE;
+    };
+    
+    // A block new at size 2^k is the only way the block holding it at 2^(k+1) can be
+    // new, so most accesses stop after one set probe
+    std::vector<BlockSet> blocks(DECODED_TRACE_BLOCK_BITS);
+    SpillArray<uint64_t> write_bits, fetch_bits;
+    SpillArray<uint16_t> cores;                  // Allocated at the first nonzero core
+    bool spilled = true;
+    bool processed = for_each_trace_file_entry(file, [&](const TraceEntry& entry, uint64_t, std::string_view) {
+        uint64_t i = header.record_count++;
+        if ((i & 63) == 0) {
+            spilled = spilled && write_bits.push_back(0) && fetch_bits.push_back(0);
+        }
+        if (!spilled) return;
+        uint64_t bit = uint64_t(1) << (i & 63);
+        if (entry.operation == 'w') {
+            write_bits[i / 64] |= bit;
+            header.writes++;
+        } else if (entry.operation == 'i') {
+            fetch_bits[i / 64] |= bit;
+            header.fetches++;
+        } else {
+            header.reads++;
+        }
+        if (entry.core != 0 && !(header.flags & DECODED_TRACE_CORES)) {
+            header.flags |= DECODED_TRACE_CORES;
+            spilled = cores.resize(i);
+        }
+        if (header.flags & DECODED_TRACE_CORES) {
+            spilled = spilled && cores.push_back(static_cast<uint16_t>(entry.core));
+        }
+        if (entry.address > 0xFFFFFFFFul && !(header.flags & DECODED_TRACE_WIDE)) {
+            flush();
+            widen();
+        }
+        pending[pending_count++] = entry.address;
+        if (pending_count == 4096) {
+            flush();
+        }
+        for (int k = 0; k < DECODED_TRACE_BLOCK_BITS && blocks[k].insert(entry.address >> k); k++) {
+            header.unique_blocks[k]++;
+        }
+        header.min_address = std::min<uint64_t>(header.min_address, entry.address);
+        header.max_address = std::max<uint64_t>(header.max_address, entry.address);
+    });
+    if (!processed) {
+        out.close();
+        std::remove(temporary.c_str());
+        return false;
+    }
+    flush();
+    if (header.record_count == 0) {
+        header.min_address = 0;
+    }
+    
+    static const char padding[8] = {};
+    DecodedTraceLayout layout(header.record_count, header.flags);
+    size_t address_bytes = (header.flags & DECODED_TRACE_WIDE) ? sizeof(uint64_t) : sizeof(uint32_t);
+    out.write(padding, layout.write_bits - layout.addresses - header.record_count * address_bytes);
+    if (write_bits.size() > 0) {
+        out.write(reinterpret_cast<const char*>(&write_bits[0]), write_bits.size() * sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(&fetch_bits[0]), fetch_bits.size() * sizeof(uint64_t));
+    }
+    if (header.flags & DECODED_TRACE_CORES) {
+        out.write(reinterpret_cast<const char*>(&cores[0]), cores.size() * sizeof(uint16_t));
+    }
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!spilled || !out || std::rename(temporary.c_str(), sidecar.c_str()) != 0) {
+        std::cerr << "Warning: Cannot write decoded trace index '" << sidecar << "'" << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Header of sidecar when it is a complete index of the current source; false if stale
+bool read_decoded_trace_header(const std::string& sidecar, const struct stat& source, DecodedTraceHeader& header) {
+    std::ifstream in(sidecar, std::ios::binary);
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        !is_decoded_trace(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+        header.version != DECODED_TRACE_VERSION) {
+        return false;
+    }
+    struct stat info;
+    int64_t mtime_ns = static_cast<int64_t>(source.st_mtim.tv_sec) * 1000000000 + source.st_mtim.tv_nsec;
+    return stat(sidecar.c_str(), &info) == 0 &&
+           static_cast<size_t>(info.st_size) == DecodedTraceLayout(header.record_count, header.flags).size &&
+           header.source_size == static_cast<uint64_t>(source.st_size) && header.source_mtime_ns == mtime_ns;
+}
+
+// Make sure the decoded index of trace_file is current, building it if needed
+bool ensure_decoded_trace(const std::string& trace_file, DecodedTraceHeader& header) {
+    struct stat source;
+    if (stat(trace_file.c_str(), &source) != 0 || !S_ISREG(source.st_mode)) {
+        return false; // Pipes and devices are read directly
+    }
+    std::string sidecar = decoded_trace_path(trace_file);
+    if (read_decoded_trace_header(sidecar, source, header)) {
+        return true;
+    }
+    
+    // One run builds under an O_EXCL lock file holding its pid; the others wait for it.
+    // A lock whose owner has died is taken over.
+    std::string lock = sidecar + ".lock";
+    while (true) {
+        int fd = ::open(lock.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if (fd >= 0) {
+            std::string pid = std::to_string(getpid());
+            bool built = ::write(fd, pid.data(), pid.size()) == static_cast<ssize_t>(pid.size());
+            ::close(fd);
+            // The previous owner may have finished between our check and the lock
+            built = built && (read_decoded_trace_header(sidecar, source, header) ||
+                              (build_decoded_trace(trace_file, source, sidecar) &&
+                               read_decoded_trace_header(sidecar, source, header)));
+            std::remove(lock.c_str());
+            return built;
+        }
+        if (errno != EEXIST) {
+            // No lock can be taken here, so neither can the index be written
+            return build_decoded_trace(trace_file, source, sidecar) && read_decoded_trace_header(sidecar, source, header);
+        }
+        
+        std::ifstream owner_file(lock);
+        long owner = 0;
+        if (owner_file >> owner && owner > 0 && kill(static_cast<pid_t>(owner), 0) != 0 && errno == ESRCH) {
+            std::remove(lock.c_str());
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (read_decoded_trace_header(sidecar, source, header)) {
+            return true;
+        }
+    }
+}
+
+// Open a trace for any mode: the file itself, or its decoded index with --trace-cache
+// (falling back to the file when the index cannot be written)
+bool open_trace_file(MappedFile& file, const std::string& trace_file) {
+    DecodedTraceHeader header;
+    if (trace_cache_enabled && ensure_decoded_trace(trace_file, header) &&
+        file.open(decoded_trace_path(trace_file))) {
+        if (area_address_bits < 64 && (header.max_address >> area_address_bits) != 0) {
+            std::cerr << "Warning: Trace addresses exceed " << area_address_bits << " bits; pass --address-bits="
+                      << 64 - __builtin_clzll(header.max_address) << " for accurate tag-array area" << std::endl;
+        }
+        return true;
+    }
+    return file.open(trace_file);
+}
+
+// Options of the single-configuration simulation mode (given as --name[=value])
+// Replacement policy selected at run time; each maps to one CacheT instantiation
+enum class ReplacementPolicy { LRU, PLRU, FIFO, RANDOM, SRRIP, BRRIP, OPT };
+
+// Layout of the final statistics: the ECE 463 text report, or one machine-readable
+// record (JSON object per line, or CSV header plus row) with no other stdout output
+enum class OutputFormat { TEXT, JSON, CSV };
+
+bool parse_output_format(const std::string& text, OutputFormat& format) {
+    static const std::pair<const char*, OutputFormat> names[] = {
+        {"text", OutputFormat::TEXT},
+        {"json", OutputFormat::JSON},
+        {"csv", OutputFormat::CSV},
+    };
+    for (const auto& entry : names) {
+        if (text == entry.first) {
+            format = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Remove --format=... from argv (for the modes with fixed positional arguments);
+// false with a message on an unknown format
+bool extract_output_format(int& argc, char* argv[], OutputFormat& format) {
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--format=", 9) == 0) {
+            if (!parse_output_format(argv[i] + 9, format)) {
+                std::cerr << "Error: --format must be one of text, json, csv" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        argv[kept++] = argv[i];
+    }
+    argc = kept;
+    return true;
+}
+
+// Discards everything written to std::cout while alive (progress and trace echo in
+// quiet runs); errors still reach std::cerr
+class StdoutMute {
+private:
+    std::streambuf* saved;
+    std::ios format;     // Width/precision/flags set while muted must not leak out
+    
+public:
+    explicit StdoutMute(bool active) : saved(nullptr), format(nullptr) {
+        if (active) {
+            format.copyfmt(std::cout);
+            saved = std::cout.rdbuf(nullptr);
+        }
+    }
+    
+    ~StdoutMute() {
+        release();
+    }
+    
+    // Restore std::cout early
+    void release() {
+        if (saved != nullptr) {
+            std::cout.rdbuf(saved);
+            std::cout.copyfmt(format);
+            std::cout.clear();
+            saved = nullptr;
+        }
+    }
+    
+    StdoutMute(const StdoutMute&) = delete;
+    StdoutMute& operator=(const StdoutMute&) = delete;
+};
+
+bool parse_replacement_policy(const std::string& text, ReplacementPolicy& policy) {
+    static const std::pair<const char*, ReplacementPolicy> names[] = {
+        {LruPolicy::name(), ReplacementPolicy::LRU},
+        {PlruPolicy::name(), ReplacementPolicy::PLRU},
+        {FifoPolicy::name(), ReplacementPolicy::FIFO},
+        {RandomPolicy::name(), ReplacementPolicy::RANDOM},
+        {SrripPolicy::name(), ReplacementPolicy::SRRIP},
+        {BrripPolicy::name(), ReplacementPolicy::BRRIP},
+        {OptPolicy::name(), ReplacementPolicy::OPT},
+    };
+    for (const auto& entry : names) {
+        if (text == entry.first) {
+            policy = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct SimulatorOptions {
+    bool verbose;            // Echo every decoded access, not just the first few
+    int pipeline_stages;     // 1 = serial, 2 = parser | simulator, 3 = parser | simulator | analyzer
+    int threads;             // > 1: set-sharded parallel simulation
+    bool streaming_analysis; // Bounded-memory online performance analysis
+    ReplacementPolicy policy;
+    std::string hierarchy_file;  // N-level hierarchy description (replaces the geometry arguments)
+    int cores;               // > 0: multi-core mode with private L1s per core and a shared L2
+    bool split_l1;           // Multi-core: separate L1I and L1D per core
+    unsigned long set_sampling;    // > 0: simulate 1 in set_sampling set groups
+    unsigned long sample_unit;     // > 0: time sampling, measured accesses per period
+    unsigned long sample_warmup;   //      warmup accesses before each unit
+    unsigned long sample_period;   //      accesses per period
+    OutputFormat format;     // Final statistics as text, JSON or CSV (JSON/CSV imply quiet)
+    bool quiet;              // Only the statistics: no configuration, contents or analyzer report
+    unsigned long checkpoint_at;   // > 0: save the cache state after this many accesses
+    std::string checkpoint_file;   // Checkpoint written or restored (default: <trace_file>.ckpt)
+    bool restore;                  // Resume from checkpoint_file, skipping the accesses it covers
+    unsigned long interval;        // > 0: per-level statistics every interval accesses
+    std::string interval_file;     // Interval rows (default: <trace_file>.intervals.csv)
+    bool classify_misses;          // Three-C classification of every level's misses
+    bool timing;                   // Cycle-approximate timing model (MSHRs, miss overlap, bandwidth)
+    std::vector<int> mshrs;        //   MSHRs per level, from L1 (last value repeats)
+    std::vector<int> bus_cycles;   //   Cycles per block on the link below each level
+    
+    SimulatorOptions() : verbose(false), pipeline_stages(1), threads(1), streaming_analysis(false),
+                         policy(ReplacementPolicy::LRU), cores(0), split_l1(false), set_sampling(0),
+                         sample_unit(0), sample_warmup(0), sample_period(0), format(OutputFormat::TEXT),
+                         quiet(false), checkpoint_at(0), restore(false), interval(0),
+                         classify_misses(false), timing(false) {}
+};
+
+// Parse a comma-separated list of positive integers ("8,16")
+bool parse_positive_list(const std::string& text, std::vector<int>& values) {
+    values.clear();
+    const char* p = text.c_str();
+    while (*p != '\0') {
+        char* end = nullptr;
+        long value = std::strtol(p, &end, 10);
+        if (end == p || value < 1 || value > 65536 || (*end != ',' && *end != '\0')) {
+            return false;
+        }
+        values.push_back(static_cast<int>(value));
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return !values.empty();
+}
+
+// Split argv into positional arguments and --options; false (with a message) on a bad option
+bool parse_simulator_options(int argc, char* argv[], SimulatorOptions& options,
+                             std::vector<std::string>& positional) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            positional.push_back(arg);
+            continue;
+        }
+        
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+        
+        if (name == "--verbose" && value.empty()) {
+            options.verbose = true;
+        } else if (name == "--pipeline") {
+            options.pipeline_stages = value.empty() ? 2 : std::atoi(value.c_str());
+            if (options.pipeline_stages != 2 && options.pipeline_stages != 3) {
+                std::cerr << "Error: --pipeline accepts 2 or 3 stages" << std::endl;
+                return false;
+            }
+        } else if (name == "--streaming-analysis" && value.empty()) {
+            options.streaming_analysis = true;
+        } else if (name == "--policy") {
+            if (!parse_replacement_policy(value, options.policy)) {
+                std::cerr << "Error: --policy must be one of lru, plru, fifo, random, srrip, brrip, opt" << std::endl;
+                return false;
+            }
+        } else if (name == "--cores") {
+            options.cores = std::atoi(value.c_str());
+            if (options.cores < 1 || options.cores > MAX_TRACE_CORES) {
+                std::cerr << "Error: --cores must be between 1 and " << MAX_TRACE_CORES << std::endl;
+                return false;
+            }
+        } else if (name == "--set-sampling") {
+            char* end = nullptr;
+            options.set_sampling = std::strtoul(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0' || options.set_sampling < 2) {
+                std::cerr << "Error: --set-sampling expects K >= 2 (simulate 1 in K set groups)" << std::endl;
+                return false;
+            }
+        } else if (name == "--time-sampling") {
+            unsigned long fields[3] = {0, 0, 0};
+            int count = 0;
+            const char* p = value.c_str();
+            while (count < 3 && *p != '\0') {
+                char* end = nullptr;
+                fields[count++] = std::strtoul(p, &end, 10);
+                p = (*end == ',') ? end + 1 : end;
+                if (end == p && *p != '\0') break;
+            }
+            options.sample_unit = fields[0];
+            options.sample_warmup = fields[1];
+            options.sample_period = fields[2];
+            if (count != 3 || *p != '\0' || options.sample_unit == 0 ||
+                options.sample_unit + options.sample_warmup > options.sample_period) {
+                std::cerr << "Error: --time-sampling expects UNIT,WARMUP,PERIOD with UNIT > 0 and "
+                          << "UNIT + WARMUP <= PERIOD" << std::endl;
+                return false;
+            }
+        } else if (name == "--checkpoint-at") {
+            char* end = nullptr;
+            options.checkpoint_at = std::strtoul(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0' || options.checkpoint_at == 0) {
+                std::cerr << "Error: --checkpoint-at expects a positive access count" << std::endl;
+                return false;
+            }
+        } else if (name == "--checkpoint-file" && !value.empty()) {
+            options.checkpoint_file = value;
+        } else if (name == "--restore") {
+            options.restore = true;
+            if (!value.empty()) {
+                options.checkpoint_file = value;
+            }
+        } else if (name == "--interval") {
+            char* end = nullptr;
+            options.interval = std::strtoul(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0' || options.interval == 0) {
+                std::cerr << "Error: --interval expects a positive access count" << std::endl;
+                return false;
+            }
+        } else if (name == "--interval-file" && !value.empty()) {
+            options.interval_file = value;
+        } else if (name == "--format") {
+            if (!parse_output_format(value, options.format)) {
+                std::cerr << "Error: --format must be one of text, json, csv" << std::endl;
+                return false;
+            }
+            options.quiet = options.quiet || options.format != OutputFormat::TEXT;
+        } else if (name == "--quiet" && value.empty()) {
+            options.quiet = true;
+        } else if (name == "--classify-misses" && value.empty()) {
+            options.classify_misses = true;
+        } else if (name == "--timing" && value.empty()) {
+            options.timing = true;
+        } else if (name == "--mshrs") {
+            if (!parse_positive_list(value, options.mshrs)) {
+                std::cerr << "Error: --mshrs expects positive counts per level, e.g. 8,16" << std::endl;
+                return false;
+            }
+        } else if (name == "--bus-cycles") {
+            if (!parse_positive_list(value, options.bus_cycles)) {
+                std::cerr << "Error: --bus-cycles expects positive cycle counts per level, e.g. 1,4" << std::endl;
+                return false;
+            }
+        } else if (name == "--split-l1" && value.empty()) {
+            options.split_l1 = true;
+        } else if (name == "--hierarchy" && !value.empty()) {
+            options.hierarchy_file = value;
+        } else if (name == "--threads") {
+            options.threads = std::atoi(value.c_str());
+            if (options.threads < 1) {
+                std::cerr << "Error: --threads must be a positive integer" << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Error: Unknown option '" << arg << "'" << std::endl;
+            return false;
+        }
+    }
+    if (options.threads > 1 && options.pipeline_stages > 1) {
+        std::cerr << "Error: --threads and --pipeline cannot be combined" << std::endl;
+        return false;
+    }
+    if ((options.set_sampling > 0 || options.sample_unit > 0) &&
+        (options.set_sampling > 0) + (options.sample_unit > 0) + (options.threads > 1) +
+        (options.pipeline_stages > 1) + (options.cores > 0) + !options.hierarchy_file.empty() > 1) {
+        std::cerr << "Error: --set-sampling and --time-sampling run serially and cannot be combined with each"
+                  << " other or with --threads, --pipeline, --cores or --hierarchy" << std::endl;
+        return false;
+    }
+    if ((options.checkpoint_at > 0 || options.restore) &&
+        ((options.checkpoint_at > 0 && options.restore) || options.threads > 1 || options.pipeline_stages > 1 ||
+         options.cores > 0 || !options.hierarchy_file.empty() || options.set_sampling > 0 || options.sample_unit > 0)) {
+        std::cerr << "Error: --checkpoint-at and --restore run serially and cannot be combined with each other"
+                  << " or with --threads, --pipeline, --cores, --hierarchy or sampling" << std::endl;
+        return false;
+    }
+    if (options.interval > 0 && (options.threads > 1 || options.cores > 0 || options.set_sampling > 0 ||
+                                 options.sample_unit > 0)) {
+        std::cerr << "Error: --interval cannot be combined with --threads, --cores or sampling" << std::endl;
+        return false;
+    }
+    if (options.classify_misses && (options.threads > 1 || options.cores > 0 || options.set_sampling > 0 ||
+                                    options.sample_unit > 0 || options.checkpoint_at > 0 || options.restore)) {
+        std::cerr << "Error: --classify-misses needs the full access stream of each cache and cannot be combined"
+                  << " with --threads, --cores, sampling or checkpoints" << std::endl;
+        return false;
+    }
+    if ((!options.mshrs.empty() || !options.bus_cycles.empty()) && !options.timing) {
+        std::cerr << "Error: --mshrs and --bus-cycles require --timing" << std::endl;
+        return false;
+    }
+    if (options.timing && (options.threads > 1 || options.pipeline_stages > 1 || options.cores > 0 ||
+                           options.set_sampling > 0 || options.sample_unit > 0 || options.checkpoint_at > 0 ||
+                           options.restore)) {
+        std::cerr << "Error: --timing follows one access stream in order and cannot be combined with --threads,"
+                  << " --pipeline, --cores, sampling or checkpoints" << std::endl;
+        return false;
+    }
+    if (options.split_l1 && options.cores == 0) {
+        std::cerr << "Error: --split-l1 requires --cores=N" << std::endl;
+        return false;
+    }
+    if (options.cores > 0 && (options.pipeline_stages > 1 || !options.hierarchy_file.empty())) {
+        std::cerr << "Error: --cores cannot be combined with --pipeline or --hierarchy" << std::endl;
+        return false;
+    }
+    if (!options.hierarchy_file.empty() &&
+        (options.threads > 1 || options.pipeline_stages > 1 || options.streaming_analysis)) {
+        std::cerr << "Error: --hierarchy runs serially without the performance analyzer" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// A block of decoded trace entries handed between pipeline stages
+struct TraceBatch {
+    static const size_t CAPACITY = 4096;
+    std::vector<TraceEntry> entries;
+    
+    TraceBatch() {
+        entries.reserve(CAPACITY);
+    }
+};
+
+// Lock-free ring of reusable trace batches with a single producer (the parser) and
+// one or two in-order consumers (the simulator and optionally the analyzer). Every
+// consumer reads every batch; a slot is recycled once all consumers released it.
+class TraceBatchRing {
+public:
+    static const int MAX_CONSUMERS = 2;
+    
+private:
+    static const size_t SLOTS = 16;
+    
+    std::vector<TraceBatch> slots;
+    int consumers;
+    alignas(64) std::atomic<size_t> write_index;
+    alignas(64) std::atomic<size_t> read_index[MAX_CONSUMERS];
+    alignas(64) std::atomic<bool> closed;
+    
+    static void backoff(int& spins) {
+        if (++spins > 64) {
+            std::this_thread::yield();
+        }
+    }
+    
+    size_t slowest_reader() const {
+        size_t slowest = read_index[0].load(std::memory_order_acquire);
+        for (int c = 1; c < consumers; c++) {
+            slowest = std::min(slowest, read_index[c].load(std::memory_order_acquire));
+        }
+        return slowest;
+    }
+    
+public:
+    explicit TraceBatchRing(int num_consumers)
+        : slots(SLOTS), consumers(num_consumers), write_index(0), closed(false) {
+        for (int c = 0; c < MAX_CONSUMERS; c++) {
+            read_index[c].store(0);
+        }
+    }
+    
+    // Producer: wait for a free slot and return it emptied
+    TraceBatch* acquire_write() {
+        size_t write = write_index.load(std::memory_order_relaxed);
+        int spins = 0;
+        while (write - slowest_reader() == SLOTS) {
+            backoff(spins);
+        }
+        TraceBatch* batch = &slots[write % SLOTS];
+        batch->entries.clear();
+        return batch;
+    }
+    
+    // Producer: make the slot returned by acquire_write visible to the consumers
+    void publish() {
+        write_index.store(write_index.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    
+    // Producer: no more batches will be published
+    void close() {
+        closed.store(true, std::memory_order_release);
+    }
+    
+    // Consumer: wait for the next batch; nullptr once the producer closed and all were read
+    TraceBatch* acquire_read(int consumer) {
+        size_t read = read_index[consumer].load(std::memory_order_relaxed);
+        int spins = 0;
+        while (read == write_index.load(std::memory_order_acquire)) {
+            if (closed.load(std::memory_order_acquire) &&
+                read == write_index.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            backoff(spins);
+        }
+        return &slots[read % SLOTS];
+    }
+    
+    // Consumer: done with the batch returned by acquire_read
+    void release(int consumer) {
+        read_index[consumer].store(read_index[consumer].load(std::memory_order_relaxed) + 1,
+                                   std::memory_order_release);
+    }
+};
+
+// Windowed statistics (--interval=K): every K accesses, one CSV row with each level's
+// accesses, misses, miss rate and writebacks over the window and the dirty blocks it
+// holds at the window's end. Rows are deltas from the counters snapshotted at the
+// previous boundary and the dirty count is kept by the cache, so a boundary costs a
+// few subtractions per level however large the caches are.
+template <class CacheType>
+class IntervalRecorder {
+public:
+    typedef std::vector<std::pair<std::string, const CacheType*>> Levels;
+    
+private:
+    typedef typename CacheType::CacheStats Stats;
+    
+    std::ofstream out;
+    std::string filename;
+    unsigned long interval;
+    unsigned long start;          // First access of the open window
+    unsigned long index;          // Number of the open window
+    Levels levels;
+    std::vector<Stats> previous;
+    
+public:
+    IntervalRecorder() : interval(0), start(0), index(0) {}
+    
+    // Start recording at access first_access (non-zero after a restore) into file
+    bool open(const std::string& file, unsigned long k, const Levels& cache_levels, unsigned long first_access) {
+        out.open(file);
+        if (!out.is_open()) {
+            std::cerr << "Error: Cannot open interval file '" << file << "'" << std::endl;
+            return false;
+        }
+        filename = file;
+        interval = k;
+        start = first_access;
+        index = first_access / k;
+        levels = cache_levels;
+        out << "interval,first_access,last_access";
+        for (const auto& level : levels) {
+            const std::string& name = level.first;
+            out << ',' << name << "_accesses," << name << "_misses," << name << "_miss_rate,"
+                << name << "_writebacks," << name << "_dirty_blocks";
+            previous.push_back(level.second->get_stats());
+        }
+        out << '\n';
+        return true;
+    }
+    
+    // Accesses left in the open window (unbounded when not recording)
+    unsigned long remaining(unsigned long accesses) const {
+        return interval == 0 ? ~0UL : interval - accesses % interval;
+    }
+    
+    bool due(unsigned long accesses) const {
+        return interval > 0 && accesses % interval == 0;
+    }
+    
+    // Close the window ending before access number accesses; the caches must have
+    // simulated every access up to there
+    void record(unsigned long accesses) {
+        if (interval == 0 || accesses == start) {
+            return;
+        }
+        out << index << ',' << start << ',' << accesses - 1;
+        for (size_t k = 0; k < levels.size(); k++) {
+            const Stats& now = levels[k].second->get_stats();
+            const Stats& before = previous[k];
+            unsigned long count = (now.reads + now.writes) - (before.reads + before.writes);
+            unsigned long misses = (now.read_misses + now.write_misses) - (before.read_misses + before.write_misses);
+            out << ',' << count << ',' << misses << ',' << std::fixed << std::setprecision(6)
+                << (count > 0 ? static_cast<double>(misses) / count : 0.0) << ','
+                << now.writebacks - before.writebacks << ',' << levels[k].second->get_dirty_blocks_count();
+            previous[k] = now;
+        }
+        out << '\n';
+        index++;
+        start = accesses;
+    }
+    
+    // Write the last, possibly partial, window; false with a message on a write error
+    bool finish(unsigned long accesses) {
+        if (interval == 0) {
+            return true;
+        }
+        record(accesses);
+        out.close();
+        if (!out) {
+            std::cerr << "Error: Failed writing interval file '" << filename << "'" << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+// Miss status holding registers of one level in the timing model (--timing): up to
+// capacity block fills in flight. Fills are indexed by block, so a later access to a
+// block still in flight merges into its entry instead of issuing a second request.
+// They are also filed by completion cycle in a bucketed timing wheel: one bucket per
+// cycle plus an occupancy bitmap, so advancing the clock retires each completed fill
+// in O(1) and skips idle stretches 64 cycles per word. A fill beyond the wheel's
+// horizon shares a bucket with nearer ones and is kept until its own lap comes round.
+class MshrFile {
+private:
+    static constexpr uint32_t NONE = ~0u;
+    static constexpr size_t WHEEL_SIZE = 1024;         // Cycles covered by one lap (multiple of 64)
+    static constexpr size_t WHEEL_MASK = WHEEL_SIZE - 1;
+    
+    struct Entry {
+        uint64_t block;
+        uint64_t ready;                            // Cycle the fill completes, 0 = free entry
+        uint32_t next;                             // Next entry in the same bucket
+    };
+    std::vector<Entry> entries;
+    std::vector<uint32_t> free_entries;
+    std::vector<uint32_t> buckets;                 // First entry of each bucket
+    std::vector<uint64_t> occupied;                // Bit per non-empty bucket
+    BlockPositionTable in_flight;                  // Block -> entry of its newest fill
+    uint64_t clock;                                // Every fill completing by clock has retired
+    
+    // Offset from bucket from of the first non-empty bucket, or limit if none is closer
+    size_t scan(size_t from, size_t limit) const {
+        size_t d = 0;
+        while (d < limit) {
+            size_t bucket = (from + d) & WHEEL_MASK;
+            uint64_t word = occupied[bucket >> 6] >> (bucket & 63);
+            if (word != 0) {
+                return std::min(limit, d + __builtin_ctzll(word));
+            }
+            d += 64 - (bucket & 63);
+        }
+        return limit;
+    }
+    
+    // Release the fills of one bucket completing by cycle (later laps stay)
+    void retire_bucket(size_t bucket, uint64_t cycle) {
+        uint32_t* link = &buckets[bucket];
+        while (*link != NONE) {
+            uint32_t e = *link;
+            Entry& entry = entries[e];
+            if (entry.ready > cycle) {
+                link = &entry.next;
+                continue;
+            }
+            *link = entry.next;
+            if (in_flight.find(entry.block, NONE) == e) {
+                in_flight.erase(entry.block);
+            }
+            entry.ready = 0;
+            free_entries.push_back(e);
+        }
+        if (buckets[bucket] == NONE) {
+            occupied[bucket >> 6] &= ~(uint64_t(1) << (bucket & 63));
+        }
+    }
+    
+public:
+    explicit MshrFile(int capacity)
+        : entries(capacity, Entry{0, 0, NONE}), buckets(WHEEL_SIZE, NONE), occupied(WHEEL_SIZE / 64, 0),
+          in_flight(64), clock(0) {
+        for (int e = capacity - 1; e >= 0; e--) {
+            free_entries.push_back(static_cast<uint32_t>(e));
+        }
+    }
+    
+    int capacity() const { return static_cast<int>(entries.size()); }
+    int outstanding() const { return static_cast<int>(entries.size() - free_entries.size()); }
+    bool full() const { return free_entries.empty(); }
+    
+    // Retire every fill completing by cycle (earlier cycles are ignored)
+    void advance(uint64_t cycle) {
+        if (cycle <= clock) {
+            return;
+        }
+        if (outstanding() > 0) {
+            size_t span = static_cast<size_t>(std::min<uint64_t>(cycle - clock, WHEEL_SIZE));
+            size_t from = (clock + 1) & WHEEL_MASK;
+            for (size_t d = scan(from, span); d < span; d += 1 + scan((from + d + 1) & WHEEL_MASK, span - d - 1)) {
+                retire_bucket((from + d) & WHEEL_MASK, cycle);
+            }
+        }
+        clock = cycle;
+    }
+    
+    // Completion cycle of the fill of block in flight, or 0 if none
+    uint64_t find(uint64_t block) const {
+        uint32_t e = static_cast<uint32_t>(in_flight.find(block, NONE));
+        return e == NONE ? 0 : entries[e].ready;
+    }
+    
+    // Earliest completion among the fills in flight (at least one must be)
+    uint64_t next_release() const {
+        size_t from = (clock + 1) & WHEEL_MASK;
+        for (size_t d = scan(from, WHEEL_SIZE); d < WHEEL_SIZE;
+             d += 1 + scan((from + d + 1) & WHEEL_MASK, WHEEL_SIZE - d - 1)) {
+            uint64_t cycle = clock + 1 + d;
+            for (uint32_t e = buckets[(from + d) & WHEEL_MASK]; e != NONE; e = entries[e].next) {
+                if (entries[e].ready == cycle) {
+                    return cycle;
+                }
+            }
+        }
+        // Only fills beyond the horizon are left
+        uint64_t earliest = ~uint64_t(0);
+        for (const Entry& entry : entries) {
+            if (entry.ready != 0) {
+                earliest = std::min(earliest, entry.ready);
+            }
+        }
+        return earliest;
+    }
+    
+    // Track a fill of block completing at ready (> the clock); an entry must be free
+    void allocate(uint64_t block, uint64_t ready) {
+        uint32_t e = free_entries.back();
+        free_entries.pop_back();
+        size_t bucket = ready & WHEEL_MASK;
+        entries[e] = Entry{block, ready, buckets[bucket]};
+        buckets[bucket] = e;
+        occupied[bucket >> 6] |= uint64_t(1) << (bucket & 63);
+        in_flight.exchange(block, e, NONE);
+    }
+};
+
+// Cycle-approximate timing of a cache hierarchy (--timing), layered on the functional
+// caches: each access is resolved by them as usual and the counters they move (which
+// levels missed, which wrote back or prefetched) are then replayed against a model
+// of time. An in-order core issues one access per cycle and never waits for data,
+// only for a free L1 MSHR, so misses overlap up to the MSHR limits. A miss takes an
+// MSHR at its level for as long as its fill is in flight; a hit on a block whose fill
+// has not arrived merges into that MSHR and completes with it. Each link below a
+// level (to the next level or memory) moves one block per bus_cycles, and requests,
+// writebacks and prefetches queue for it in order. A hit on a prefetched block waits
+// for that block's transfer to arrive. Functional results are unchanged.
+template <class CacheType>
+class TimingModel {
+private:
+    struct Level {
+        CacheType* cache;
+        uint64_t block_size;
+        int hit_time;
+        int bus_cycles;                  // Cycles per block on the link below
+        MshrFile mshrs;
+        uint64_t link_free;              // First cycle the link below is idle
+        
+        // Functional counters before the current access
+        unsigned long read_misses, write_misses, writebacks, prefetches;
+        
+        unsigned long primary_misses;    // Fills requested (MSHRs allocated)
+        unsigned long merged_misses;     // Accesses that joined a fill in flight
+        uint64_t miss_cycles;            // Sum of fill latencies
+        uint64_t mshr_wait_cycles;       // Waiting for a free MSHR
+        uint64_t link_wait_cycles;       // Waiting for the link below
+        uint64_t busy_cycles;            // Cycles with at least one fill in flight
+        uint64_t busy_until;
+        
+        // Arrival cycle of each prefetched block, pruned of arrived blocks as it grows
+        std::unordered_map<uint64_t, uint64_t> prefetch_ready;
+        size_t prefetch_prune_at;
+        unsigned long late_prefetch_hits; // Hits that waited for a prefetch in flight
+        
+        Level(CacheType* level, int mshr_count, int bus)
+            : cache(level), block_size(level->get_block_size()), hit_time(level->get_stats().hit_time),
+              bus_cycles(bus), mshrs(mshr_count), link_free(0), read_misses(0), write_misses(0), writebacks(0),
+              prefetches(0), primary_misses(0), merged_misses(0), miss_cycles(0), mshr_wait_cycles(0),
+              link_wait_cycles(0), busy_cycles(0), busy_until(0), prefetch_prune_at(PREFETCH_PRUNE_MIN),
+              late_prefetch_hits(0) {}
+    };
+    
+    std::vector<Level> levels;
+    std::vector<std::string> names;
+    int memory_latency;
+    uint64_t now;                        // Issue cycle of the next access
+    uint64_t finish;                     // Latest completion so far
+    uint64_t latency_cycles;             // Sum of issue-to-completion latencies
+    uint64_t stall_cycles;               // Issue stalled on a full L1 MSHR file
+    unsigned long accesses;
+    
+    // Occupy the link below level for one block from cycle on; returns the start cycle
+    uint64_t transfer(Level& level, uint64_t cycle) {
+        uint64_t start = std::max(cycle, level.link_free);
+        level.link_wait_cycles += start - cycle;
+        level.link_free = start + level.bus_cycles;
+        return start;
+    }
+    
+    // Cycle at which level k delivers address for a request arriving at cycle
+    uint64_t resolve(size_t k, unsigned long address, uint64_t cycle) {
+        if (k == levels.size()) {
+            return cycle + memory_latency;
+        }
+        Level& level = levels[k];
+        level.mshrs.advance(cycle);
+        uint64_t block = address / level.block_size;
+        const auto& stats = level.cache->get_stats();
+        bool missed = stats.read_misses != level.read_misses || (k == 0 && stats.write_misses != level.write_misses);
+        if (!missed) {
+            uint64_t ready = cycle + level.hit_time;
+            uint64_t fill = level.mshrs.find(block);
+            if (fill > ready) {
+                level.merged_misses++;
+                ready = fill;
+            }
+            if (!level.prefetch_ready.empty()) {
+                auto prefetched = level.prefetch_ready.find(block);
+                if (prefetched != level.prefetch_ready.end() && prefetched->second > ready) {
+                    level.late_prefetch_hits++;
+                    ready = prefetched->second;
+                }
+            }
+            return ready;
+        }
+        
+        if (level.mshrs.full()) {
+            uint64_t released = level.mshrs.next_release();
+            level.mshr_wait_cycles += released - cycle;
+            cycle = released;
+            level.mshrs.advance(cycle);
+        }
+        uint64_t fill = resolve(k + 1, address, transfer(level, cycle + level.hit_time));
+        level.mshrs.allocate(block, fill);
+        level.primary_misses++;
+        level.miss_cycles += fill - cycle;
+        if (cycle >= level.busy_until) {
+            level.busy_cycles += fill - cycle;
+            level.busy_until = fill;
+        } else if (fill > level.busy_until) {
+            level.busy_cycles += fill - level.busy_until;
+            level.busy_until = fill;
+        }
+        return fill;
+    }
+    
+public:
+    static constexpr int DEFAULT_MSHRS = 8;
+    static constexpr size_t PREFETCH_PRUNE_MIN = 4096;
+    
+    // cache_levels runs from L1 down (each linked to the next); mshrs and bus_cycles
+    // give per-level values, the last repeated for deeper levels (empty: defaults)
+    TimingModel(const std::vector<std::pair<std::string, CacheType*>>& cache_levels,
+                const std::vector<int>& mshrs, const std::vector<int>& bus_cycles)
+        : now(0), finish(0), latency_cycles(0), stall_cycles(0), accesses(0) {
+        for (size_t k = 0; k < cache_levels.size(); k++) {
+            CacheType* cache = cache_levels[k].second;
+            bool last = k + 1 == cache_levels.size();
+            int mshr_count = mshrs.empty() ? DEFAULT_MSHRS : mshrs[std::min(k, mshrs.size() - 1)];
+            // Default links move 32 bytes per cycle on chip and 8 to memory
+            int bus = bus_cycles.empty() ? std::max(1, cache->get_block_size() / (last ? 8 : 32))
+                                         : bus_cycles[std::min(k, bus_cycles.size() - 1)];
+            levels.emplace_back(cache, mshr_count, bus);
+            names.push_back(cache_levels[k].first);
+        }
+        memory_latency = levels.back().cache->get_stats().miss_penalty;
+    }
+    
+    // Simulate one access functionally, then place it in time
+    bool access(unsigned long address, bool is_write) {
+        for (Level& level : levels) {
+            const auto& stats = level.cache->get_stats();
+            level.read_misses = stats.read_misses;
+            level.write_misses = stats.write_misses;
+            level.writebacks = stats.writebacks;
+            level.prefetches = stats.prefetches;
+        }
+        bool hit = levels.front().cache->access_with_stats(address, is_write);
+        
+        uint64_t issue = now;
+        if (!hit) {
+            MshrFile& l1 = levels.front().mshrs;
+            l1.advance(now);
+            if (l1.full()) {
+                now = l1.next_release();
+                stall_cycles += now - issue;
+            }
+        }
+        uint64_t done = resolve(0, address, now);
+        
+        // Writebacks, write-allocate fills below L1 and prefetches use the links too
+        for (size_t k = 0; k < levels.size(); k++) {
+            Level& level = levels[k];
+            const auto& stats = level.cache->get_stats();
+            unsigned long transfers = stats.writebacks - level.writebacks;
+            if (k > 0) {
+                transfers += stats.write_misses - level.write_misses;
+            }
+            for (unsigned long i = 0; i < transfers; i++) {
+                transfer(level, now);
+            }
+            
+            // A slid or refilled stream buffer ends prefetch depth blocks past the accessed
+            // block, and the newly prefetched blocks are the last ones in it
+            unsigned long prefetched = stats.prefetches - level.prefetches;
+            if (prefetched > 0) {
+                uint64_t last = address / level.block_size + level.cache->get_prefetch_depth();
+                uint64_t delay = k + 1 < levels.size() ? levels[k + 1].hit_time : memory_latency;
+                for (unsigned long i = prefetched; i > 0; i--) {
+                    level.prefetch_ready[last + 1 - i] = transfer(level, now) + delay;
+                }
+                if (level.prefetch_ready.size() >= level.prefetch_prune_at) {
+                    for (auto it = level.prefetch_ready.begin(); it != level.prefetch_ready.end();) {
+                        it = it->second <= now ? level.prefetch_ready.erase(it) : std::next(it);
+                    }
+                    level.prefetch_prune_at = std::max(PREFETCH_PRUNE_MIN, 2 * level.prefetch_ready.size());
+                }
+            }
+        }
+        
+        latency_cycles += done - issue;
+        finish = std::max(finish, done);
+        accesses++;
+        now++;
+        return hit;
+    }
+    
+    template <class Record>
+    void access_batch(const Record* records, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            access(records[i].address, records[i].operation == 'w');
+        }
+    }
+    
+    uint64_t get_cycles() const { return std::max(finish, now); }
+    
+    double get_average_latency() const {
+        return accesses > 0 ? static_cast<double>(latency_cycles) / accesses : 0.0;
+    }
+    
+    // The run's timing statistics as StatsRecord keys (timing_* and <level>_mshr_*)
+    template <class Record>
+    void add_stats(Record& record) const {
+        record.add("timing_cycles", get_cycles());
+        record.add("timing_cycles_per_access", accesses > 0 ? static_cast<double>(get_cycles()) / accesses : 0.0);
+        record.add("timing_average_latency", get_average_latency());
+        record.add("timing_stall_cycles", stall_cycles);
+        for (size_t k = 0; k < levels.size(); k++) {
+            const Level& level = levels[k];
+            std::string prefix = names[k] + "_";
+            record.add(prefix + "mshrs", level.mshrs.capacity());
+            record.add(prefix + "bus_cycles", level.bus_cycles);
+            record.add(prefix + "mshr_primary_misses", level.primary_misses);
+            record.add(prefix + "mshr_merged_misses", level.merged_misses);
+            if (k > 0) {
+                // L1 MSHR waits stall issue and are reported as timing_stall_cycles
+                record.add(prefix + "mshr_wait_cycles", level.mshr_wait_cycles);
+            }
+            record.add(prefix + "link_wait_cycles", level.link_wait_cycles);
+            record.add(prefix + "late_prefetch_hits", level.late_prefetch_hits);
+            record.add(prefix + "average_miss_latency",
+                       level.primary_misses > 0 ? static_cast<double>(level.miss_cycles) / level.primary_misses : 0.0);
+            record.add(prefix + "mlp", level.busy_cycles > 0 ? static_cast<double>(level.miss_cycles) / level.busy_cycles : 0.0);
+        }
+    }
+    
+    void print() const {
+        auto row = [](const std::string& label) -> std::ostream& {
+            return std::cout << std::setfill(' ') << std::left << std::setw(30) << (label + ":") << std::right;
+        };
+        std::cout << "===== Timing Model =====" << std::endl;
+        row("Total cycles") << get_cycles() << std::endl;
+        row("Cycles per access") << std::fixed << std::setprecision(2)
+                                 << (accesses > 0 ? static_cast<double>(get_cycles()) / accesses : 0.0) << std::endl;
+        row("Average access latency") << std::fixed << std::setprecision(2) << get_average_latency() << " cycles"
+                                      << std::endl;
+        row("Issue stall cycles (MSHRs)") << stall_cycles << std::endl;
+        for (size_t k = 0; k < levels.size(); k++) {
+            const Level& level = levels[k];
+            std::string name = names[k];
+            for (char& c : name) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            row(name + " MSHRs / bus cycles") << level.mshrs.capacity() << " / " << level.bus_cycles << std::endl;
+            row(name + " primary misses") << level.primary_misses << std::endl;
+            row(name + " merged misses") << level.merged_misses << std::endl;
+            row(name + " average miss latency") << std::fixed << std::setprecision(2)
+                << (level.primary_misses > 0 ? static_cast<double>(level.miss_cycles) / level.primary_misses : 0.0)
+                << " cycles" << std::endl;
+            row(name + " memory-level parallelism") << std::fixed << std::setprecision(2)
+                << (level.busy_cycles > 0 ? static_cast<double>(level.miss_cycles) / level.busy_cycles : 0.0)
+                << std::endl;
+            if (k > 0) {
+                row(name + " MSHR wait cycles") << level.mshr_wait_cycles << std::endl;
+            }
+            row(name + " link wait cycles") << level.link_wait_cycles << std::endl;
+            if (level.cache->has_prefetcher()) {
+                row(name + " late prefetch hits") << level.late_prefetch_hits << std::endl;
+            }
+        }
+        std::cout << std::endl;
+    }
+};
+
+// Show how the first few trace entries were interpreted
+void print_trace_entry(const TraceEntry& entry, uint64_t line_number, std::string_view line) {
+    if (line.empty()) {
+        std::cout << "Record " << line_number << ": " << entry.operation 
+                  << " " << entry.get_formatted_address() << " (binary trace)" << std::endl;
+    } else {
+        std::cout << "Line " << line_number << ": " << entry.operation 
+                  << " " << entry.get_formatted_address() 
+                  << " (from: " << line << ")" << std::endl;
+    }
+}
+
+// Pipelined trace processing: the parser runs on its own thread and feeds decoded
+// batches to the simulator (this thread) and, with three stages, an analyzer thread.
+// Every stage consumes the trace in order, so results match the serial run.
+template <class CacheType>
+bool process_trace_pipelined(const MappedFile& file, CacheType& l1_cache, PerformanceAnalyzer& analyzer,
+                             const SimulatorOptions& options, unsigned long& total_accesses,
+                             IntervalRecorder<CacheType>& intervals) {
+    bool analyzer_stage = (options.pipeline_stages == 3);
+    TraceBatchRing ring(analyzer_stage ? 2 : 1);
+    bool processed = true;
+    
+    std::thread parser([&]() {
+        unsigned long parsed = 0;
+        TraceBatch* batch = ring.acquire_write();
+        processed = for_each_trace_file_entry(file, [&](const TraceEntry& entry, uint64_t line_number, std::string_view line) {
+            if (options.verbose || parsed < 5) {
+                print_trace_entry(entry, line_number, line);
+            }
+            parsed++;
+            
+            batch->entries.push_back(entry);
+            if (batch->entries.size() == TraceBatch::CAPACITY) {
+                ring.publish();
+                batch = ring.acquire_write();
+            }
+        });
+        if (!batch->entries.empty()) {
+            ring.publish();
+        }
+        ring.close();
+    });
+    
+    std::thread analysis;
+    if (analyzer_stage) {
+        analysis = std::thread([&]() {
+            unsigned long index = 0;
+            while (TraceBatch* batch = ring.acquire_read(1)) {
+                for (const TraceEntry& entry : batch->entries) {
+                    analyzer.record_access(entry.address, entry.operation, index++);
+                }
+                ring.release(1);
+            }
+        });
+    }
+    
+    while (TraceBatch* batch = ring.acquire_read(0)) {
+        // Batches are split at interval boundaries
+        size_t size = batch->entries.size();
+        for (size_t first = 0; first < size;) {
+            size_t count = std::min<size_t>(size - first, intervals.remaining(total_accesses));
+            l1_cache.access_batch(batch->entries.data() + first, count);
+            for (size_t i = first; i < first + count; i++) {
+                const TraceEntry& entry = batch->entries[i];
+                if (!analyzer_stage) {
+                    analyzer.record_access(entry.address, entry.operation, total_accesses);
+                }
+                total_accesses++;
+                
+                if (total_accesses % 100000 == 0) {
+                    std::cout << "Processed " << total_accesses << " accesses..." << std::endl;
+                }
+            }
+            if (intervals.due(total_accesses)) {
+                intervals.record(total_accesses);
+            }
+            first += count;
+        }
+        ring.release(0);
+    }
+    
+    parser.join();
+    if (analysis.joinable()) {
+        analysis.join();
+    }
+    return processed;
+}
+
+// Simulate one level as independent set shards, one thread per shard. inputs[t] holds
+// the requests for the sets owned by shard t in trace order; each shard runs on its
+// own copy of the cache (touching only its sets) and the stats and set contents are
+// merged back into cache. When next_logs is given, the level's own next-level requests
+// are captured per shard, bucketed into next_shards shards of next_level.
+template <class CacheType>
+void simulate_level_sharded(CacheType& cache, const std::vector<const std::vector<DownstreamRequest>*>& inputs,
+                            const CacheType* next_level, int next_shards,
+                            std::vector<std::unique_ptr<DownstreamLog>>* next_logs) {
+    int shards = static_cast<int>(inputs.size());
+    std::vector<std::unique_ptr<CacheType>> shard_caches;
+    for (int t = 0; t < shards; t++) {
+        shard_caches.push_back(std::make_unique<CacheType>(cache.get_block_size(), cache.get_size(),
+                                                       cache.get_associativity()));
+        if (next_logs != nullptr) {
+            next_logs->push_back(std::make_unique<DownstreamLog>(next_level->get_block_size(),
+                                                                 next_level->get_num_sets(), next_shards));
+            shard_caches[t]->set_downstream_log(next_logs->back().get());
+        }
+    }
+    
+    std::vector<std::thread> workers;
+    for (int t = 0; t < shards; t++) {
+        workers.emplace_back([&, t]() {
+            CacheType& shard = *shard_caches[t];
+            DownstreamLog* log = next_logs != nullptr ? (*next_logs)[t].get() : nullptr;
+            for (const DownstreamRequest& request : *inputs[t]) {
+                if (log != nullptr) {
+                    log->current_seq = request.seq;
+                }
+                shard.access_with_stats(request.address, request.is_write);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    for (int t = 0; t < shards; t++) {
+        cache.stats.merge(shard_caches[t]->get_stats());
+        for (int set = t; set < cache.get_num_sets(); set += shards) {
+            cache.adopt_set(*shard_caches[t], set);
+        }
+    }
+}
+
+// Set-sharded parallel simulation. With LRU every set evolves independently, so the
+// decoded trace is partitioned by L1 set; L1->L2 requests are logged with the trace
+// position that caused them and replayed per L2 set shard in the original order.
+// The merged statistics and contents match the serial simulation exactly.
+template <class CacheType>
+bool process_trace_sharded(const MappedFile& file, CacheType& l1_cache, CacheType& l2_cache,
+                           PerformanceAnalyzer& analyzer, const SimulatorOptions& options,
+                           unsigned long& total_accesses) {
+    int l1_shards = std::min(options.threads, l1_cache.get_num_sets());
+    std::vector<std::vector<DownstreamRequest>> l1_inputs(l1_shards);
+    
+    // Decode once, partitioning accesses by the shard owning their L1 set
+    bool processed = for_each_trace_file_entry(file, [&](const TraceEntry& entry, uint64_t line_number, std::string_view line) {
+        if (options.verbose || total_accesses < 5) {
+            print_trace_entry(entry, line_number, line);
+        }
+        
+        size_t set_index = (entry.address / l1_cache.get_block_size()) % l1_cache.get_num_sets();
+        l1_inputs[set_index % l1_shards].push_back({total_accesses, entry.address, entry.operation == 'w'});
+        analyzer.record_access(entry.address, entry.operation, total_accesses);
+        total_accesses++;
+        
+        if (total_accesses % 100000 == 0) {
+            std::cout << "Processed " << total_accesses << " accesses..." << std::endl;
+        }
+    });
+    if (!processed) {
+        return false;
+    }
+    
+    std::vector<const std::vector<DownstreamRequest>*> inputs;
+    for (const auto& input : l1_inputs) {
+        inputs.push_back(&input);
+    }
+    
+    if (!l2_cache.is_enabled()) {
+        simulate_level_sharded(l1_cache, inputs, static_cast<const CacheType*>(nullptr), 0, nullptr);
+        return true;
+    }
+    
+    int l2_shards = std::min(options.threads, l2_cache.get_num_sets());
+    std::vector<std::unique_ptr<DownstreamLog>> logs;
+    simulate_level_sharded(l1_cache, inputs, &l2_cache, l2_shards, &logs);
+    l1_inputs.clear();
+    l1_inputs.shrink_to_fit();
+    
+    // Restore trace order per L2 shard. A single L1 access may issue a writeback and a
+    // fetch with the same seq; both come from the same L1 shard, so a stable sort keeps them in order.
+    std::vector<std::vector<DownstreamRequest>> l2_inputs(l2_shards);
+    std::vector<std::thread> mergers;
+    for (int k = 0; k < l2_shards; k++) {
+        mergers.emplace_back([&, k]() {
+            std::vector<DownstreamRequest>& merged = l2_inputs[k];
+            for (auto& log : logs) {
+                merged.insert(merged.end(), log->buckets[k].begin(), log->buckets[k].end());
+                std::vector<DownstreamRequest>().swap(log->buckets[k]);
+            }
+            std::stable_sort(merged.begin(), merged.end(),
+                             [](const DownstreamRequest& a, const DownstreamRequest& b) { return a.seq < b.seq; });
+        });
+    }
+    for (auto& merger : mergers) {
+        merger.join();
+    }
+    
+    inputs.clear();
+    for (const auto& input : l2_inputs) {
+        inputs.push_back(&input);
+    }
+    simulate_level_sharded(l2_cache, inputs, static_cast<const CacheType*>(nullptr), 0, nullptr);
+    return true;
+}
+
+// One access of a core's slice of a multi-core trace, tagged with its trace position
+struct CoreAccess {
+    uint64_t seq;
+    unsigned long address;
+    char operation;
+};
+
+// Private caches of one core and the log of their requests to the shared level
+template <class CacheType>
+struct CoreCaches {
+    std::unique_ptr<CacheType> data;          // L1, or L1D when split
+    std::unique_ptr<CacheType> instruction;   // L1I (split I/D only)
+    std::unique_ptr<DownstreamLog> log;
+    std::vector<CoreAccess> accesses;
+};
+
+// Multi-core system: every core has a private L1 (optionally split into L1I and L1D of
+// the L1 geometry) in front of the shared L2/LLC
+template <class CacheType>
+class MultiCoreSystem {
+private:
+    std::vector<CoreCaches<CacheType>> cores;
+    bool split;
+    
+public:
+    MultiCoreSystem(int count, bool split_l1, const CacheType& l1) : cores(count), split(split_l1) {
+        for (CoreCaches<CacheType>& core : cores) {
+            core.data = std::make_unique<CacheType>(l1.get_block_size(), l1.get_size(), l1.get_associativity());
+            if (split) {
+                core.instruction = std::make_unique<CacheType>(l1.get_block_size(), l1.get_size(),
+                                                               l1.get_associativity());
+            }
+        }
+    }
+    
+    int core_count() const { return static_cast<int>(cores.size()); }
+    bool is_split() const { return split; }
+    CoreCaches<CacheType>& core(int id) { return cores[id]; }
+    
+    // Add every private cache's statistics to the system-wide L1 totals
+    void merge_stats_into(CacheType& l1) const {
+        for (const CoreCaches<CacheType>& core : cores) {
+            l1.stats.merge(core.data->get_stats());
+            if (split) {
+                l1.stats.merge(core.instruction->get_stats());
+            }
+        }
+    }
+    
+    void print_cache_contents() const {
+        for (size_t id = 0; id < cores.size(); id++) {
+            std::string prefix = "Core " + std::to_string(id) + " L1";
+            if (split) {
+                cores[id].instruction->print_cache_contents(prefix + "I");
+            }
+            cores[id].data->print_cache_contents(prefix + (split ? "D" : ""));
+        }
+    }
+    
+    void print_core_stats() const {
+        std::cout << "===== Per-core private caches =====" << std::endl;
+        std::cout << std::setfill(' ') << std::left << std::setw(6) << "core" << std::setw(7) << "cache" << std::right
+                  << std::setw(12) << "reads" << std::setw(13) << "read misses" << std::setw(12) << "writes"
+                  << std::setw(14) << "write misses" << std::setw(11) << "miss rate" << std::setw(12) << "writebacks"
+                  << std::endl;
+        for (size_t id = 0; id < cores.size(); id++) {
+            auto row = [&](const char* name, const CacheType& cache) {
+                const auto& stats = cache.get_stats();
+                std::cout << std::left << std::setw(6) << id << std::setw(7) << name << std::right
+                          << std::setw(12) << stats.reads << std::setw(13) << stats.read_misses
+                          << std::setw(12) << stats.writes << std::setw(14) << stats.write_misses
+                          << std::setw(11) << std::fixed << std::setprecision(6) << stats.get_overall_miss_rate()
+                          << std::setw(12) << stats.writebacks << std::endl;
+            };
+            if (split) {
+                row("L1I", *cores[id].instruction);
+            }
+            row(split ? "L1D" : "L1", *cores[id].data);
+        }
+        std::cout << std::endl;
+    }
+};
+
+// Multi-core simulation of a core-tagged trace. Each core's private caches run on
+// their own thread over that core's accesses, logging their requests for the shared
+// L2 with the trace position (timestamp) of the access that caused them. The logs are
+// merged in timestamp order and replayed into the L2 (set-sharded over --threads).
+// Private caches never observe the shared level, so the result equals a serial
+// simulation of the interleaved trace.
+template <class CacheType>
+bool process_trace_multicore(const MappedFile& file, MultiCoreSystem<CacheType>& system,
+                             CacheType& l1_cache, CacheType& l2_cache, PerformanceAnalyzer& analyzer,
+                             const SimulatorOptions& options, unsigned long& total_accesses) {
+    int bad_core = -1;
+    uint64_t bad_line = 0;
+    bool processed = for_each_trace_file_entry(file, [&](const TraceEntry& entry, uint64_t line_number, std::string_view line) {
+        if (entry.core >= system.core_count()) {
+            if (bad_core < 0) {
+                bad_core = entry.core;
+                bad_line = line_number;
+            }
+            return;
+        }
+        if (options.verbose || total_accesses < 5) {
+            print_trace_entry(entry, line_number, line);
+        }
+        system.core(entry.core).accesses.push_back({total_accesses, entry.address, entry.operation});
+        analyzer.record_access(entry.address, entry.operation, total_accesses);
+        total_accesses++;
+        
+        if (total_accesses % 100000 == 0) {
+            std::cout << "Processed " << total_accesses << " accesses..." << std::endl;
+        }
+    });
+    if (!processed) {
+        return false;
+    }
+    if (bad_core >= 0) {
+        std::cerr << "Error: Trace line " << bad_line << " names core " << bad_core << " but --cores="
+                  << system.core_count() << std::endl;
+        return false;
+    }
+    
+    int l2_shards = l2_cache.is_enabled() ? std::min(options.threads, l2_cache.get_num_sets()) : 0;
+    std::vector<std::thread> workers;
+    for (int id = 0; id < system.core_count(); id++) {
+        CoreCaches<CacheType>& core = system.core(id);
+        if (l2_cache.is_enabled()) {
+            core.log = std::make_unique<DownstreamLog>(l2_cache.get_block_size(), l2_cache.get_num_sets(), l2_shards);
+            core.data->set_downstream_log(core.log.get());
+            if (core.instruction) {
+                core.instruction->set_downstream_log(core.log.get());
+            }
+        }
+        workers.emplace_back([&core]() {
+            for (const CoreAccess& access : core.accesses) {
+                if (core.log) {
+                    core.log->current_seq = access.seq;
+                }
+                CacheType& cache = (access.operation == 'i' && core.instruction) ? *core.instruction : *core.data;
+                cache.access_with_stats(access.address, access.operation == 'w');
+            }
+            std::vector<CoreAccess>().swap(core.accesses);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    system.merge_stats_into(l1_cache);
+    if (!l2_cache.is_enabled()) {
+        return true;
+    }
+    
+    // Timestamp order per L2 shard; requests with equal seq come from one core's
+    // access (writeback, then fetch) and keep their logged order under the stable sort
+    std::vector<std::vector<DownstreamRequest>> l2_inputs(l2_shards);
+    for (int k = 0; k < l2_shards; k++) {
+        std::vector<DownstreamRequest>& merged = l2_inputs[k];
+        for (int id = 0; id < system.core_count(); id++) {
+            std::vector<DownstreamRequest>& bucket = system.core(id).log->buckets[k];
+            merged.insert(merged.end(), bucket.begin(), bucket.end());
+            std::vector<DownstreamRequest>().swap(bucket);
+        }
+        std::stable_sort(merged.begin(), merged.end(),
+                         [](const DownstreamRequest& a, const DownstreamRequest& b) { return a.seq < b.seq; });
+    }
+    
+    if (l2_shards == 1) {
+        // Serial replay keeps the L2's stream buffers, which sharding does not support
+        for (const DownstreamRequest& request : l2_inputs[0]) {
+            l2_cache.access_with_stats(request.address, request.is_write);
+        }
+        return true;
+    }
+    std::vector<const std::vector<DownstreamRequest>*> inputs;
+    for (const auto& input : l2_inputs) {
+        inputs.push_back(&input);
+    }
+    simulate_level_sharded(l2_cache, inputs, static_cast<const CacheType*>(nullptr), 0, nullptr);
+    return true;
+}
+
+// Belady OPT needs the future. A forward pass spills each access as (block << 1 | write)
+// to a file-backed array, a backward pass over it builds the flat next-use index (also
+// file-backed, one position per access), and the forward simulation streams both, so
+// memory stays O(distinct blocks) however long the trace is (L1-only hierarchies).
+template <class CacheType>
+bool process_trace_opt(const MappedFile& file, CacheType& l1_cache, PerformanceAnalyzer& analyzer,
+                       const SimulatorOptions& options, unsigned long& total_accesses) {
+    const unsigned long block_size = l1_cache.get_block_size();
+    SpillArray<uint64_t> accesses;
+    bool spilled = true;
+    bool processed = for_each_trace_file_entry(file, [&](const TraceEntry& entry, uint64_t line_number, std::string_view line) {
+        if (options.verbose || accesses.size() < 5) {
+            print_trace_entry(entry, line_number, line);
+        }
+        analyzer.record_access(entry.address, entry.operation, accesses.size());
+        uint64_t block_addr = entry.address / block_size;
+        spilled = spilled && accesses.push_back((block_addr << 1) | (entry.operation == 'w'));
+    });
+    if (!processed) {
+        return false;
+    }
+    
+    SpillArray<uint64_t> next_use;
+    if (!spilled || !next_use.resize(accesses.size())) {
+        std::cerr << "Error: Cannot allocate the OPT next-use index" << std::endl;
+        return false;
+    }
+    
+    std::cout << "Building OPT next-use index for " << accesses.size() << " accesses..." << std::endl;
+    BlockPositionTable upcoming;
+    for (size_t i = accesses.size(); i-- > 0;) {
+        next_use[i] = upcoming.exchange(accesses[i] >> 1, i, OptPolicy::NEVER);
+    }
+    
+    accesses.advise(MADV_SEQUENTIAL);
+    next_use.advise(MADV_SEQUENTIAL);
+    for (size_t i = 0; i < accesses.size(); i++) {
+        l1_cache.replacement_policy().set_next_use(next_use[i]);
+        l1_cache.access_with_stats((accesses[i] >> 1) * block_size, (accesses[i] & 1) != 0);
+        total_accesses++;
+        
+        if (total_accesses % 100000 == 0) {
+            std::cout << "Processed " << total_accesses << " accesses..." << std::endl;
+        }
+    }
+    return true;
+}
+
+// Result of a sampled simulation: the cache statistics are scaled estimates, and the
+// miss rates carry 95% confidence half-widths from the spread across sampling units
+struct SamplingEstimate {
+    std::string method;          // Human-readable description of the sampling scheme
+    unsigned long units;         // Sampling units simulated (set groups or time windows)
+    unsigned long population;    // Units a full simulation would cover
+    double scale;                // Factor the counters were multiplied by
+    double l1_half_width;        // L1 overall miss rate
+    double l2_half_width;        // L2 demand-read miss rate
+    
+    SamplingEstimate() : units(0), population(0), scale(1.0), l1_half_width(0.0), l2_half_width(0.0) {}
+};
+
+// Per-unit counts behind a ratio estimate (misses / accesses)
+struct SamplingUnitCounts {
+    std::vector<double> l1_accesses, l1_misses, l2_reads, l2_read_misses;
+    
+    template <class Stats>
+    void add(const Stats& l1, const Stats& l2) {
+        l1_accesses.push_back(static_cast<double>(l1.reads + l1.writes));
+        l1_misses.push_back(static_cast<double>(l1.read_misses + l1.write_misses));
+        l2_reads.push_back(static_cast<double>(l2.reads));
+        l2_read_misses.push_back(static_cast<double>(l2.read_misses));
+    }
+};
+
+// 95% half-width of the ratio estimator sum(y) / sum(x) over n of population units
+// (Taylor-linearized variance, finite-population corrected)
+double ratio_confidence_half_width(const std::vector<double>& y, const std::vector<double>& x, double population) {
+    size_t n = x.size();
+    double sum_x = std::accumulate(x.begin(), x.end(), 0.0);
+    if (n < 2 || sum_x <= 0.0) return 0.0;
+    double ratio = std::accumulate(y.begin(), y.end(), 0.0) / sum_x;
+    double mean_x = sum_x / n;
+    double residuals = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double r = y[i] - ratio * x[i];
+        residuals += r * r;
+    }
+    double fpc = population > 0 ? std::max(0.0, 1.0 - n / population) : 1.0;
+    double variance = fpc * residuals / (n - 1) / (n * mean_x * mean_x);
+    return 1.96 * std::sqrt(variance);
+}
+
+template <class CacheType>
+void finish_sampling_estimate(CacheType& l1_cache, CacheType& l2_cache, const SamplingUnitCounts& counts,
+                              SamplingEstimate& estimate) {
+    estimate.units = counts.l1_accesses.size();
+    double population = static_cast<double>(estimate.population);
+    estimate.l1_half_width = ratio_confidence_half_width(counts.l1_misses, counts.l1_accesses, population);
+    estimate.l2_half_width = ratio_confidence_half_width(counts.l2_read_misses, counts.l2_reads, population);
+    l1_cache.stats.scale(estimate.scale);
+    l2_cache.stats.scale(estimate.scale);
+}
+
+// Set sampling. With a shared block size, block b maps to L1 set b mod S1 and L2 set
+// b mod S2, so the blocks with equal b mod G, G = min(S1, S2), form a set group that
+// never interacts with any other group. Only a seeded random 1/K of the groups are
+// simulated; their statistics are exact, and the totals are scaled by G / groups.
+template <class CacheType>
+bool process_trace_set_sampled(const MappedFile& file, CacheType& l1_cache, CacheType& l2_cache,
+                               PerformanceAnalyzer& analyzer, const SimulatorOptions& options,
+                               unsigned long& total_accesses, SamplingEstimate& estimate) {
+    unsigned long groups = l1_cache.get_num_sets();
+    if (l2_cache.is_enabled()) {
+        groups = std::min(groups, static_cast<unsigned long>(l2_cache.get_num_sets()));
+    }
+    unsigned long sampled = std::max(1ul, groups / options.set_sampling);
+    
+    // Partial Fisher-Yates: the first `sampled` entries are the chosen groups
+    std::vector<unsigned long> order(groups);
+    for (unsigned long g = 0; g < groups; g++) order[g] = g;
+    std::mt19937_64 rng(0x5e75a3b1ull);
+    std::vector<int> unit_of(groups, -1);
+    for (unsigned long i = 0; i < sampled; i++) {
+        std::swap(order[i], order[i + rng() % (groups - i)]);
+        unit_of[order[i]] = static_cast<int>(i);
+    }
+    
+    using CacheStats = typename CacheType::CacheStats;
+    std::vector<CacheStats> l1_units(sampled), l2_units(sampled);
+    unsigned long block_size = l1_cache.get_block_size();
+    bool processed = for_each_trace_file_entry(file, [&](const TraceEntry& entry, uint64_t line_number, std::string_view line) {
+        if (options.verbose || total_accesses < 5) {
+            print_trace_entry(entry, line_number, line);
+        }
+        total_accesses++;
+        int unit = unit_of[(entry.address / block_size) % groups];
+        if (unit < 0) {
+            return;
+        }
+        
+        bool is_write = (entry.operation == 'w');
+        unsigned long l2_reads = l2_cache.get_stats().reads;
+        unsigned long l2_read_misses = l2_cache.get_stats().read_misses;
+        bool hit = l1_cache.access_with_stats(entry.address, is_write);
+        CacheStats& l1 = l1_units[unit];
+        (is_write ? l1.writes : l1.reads)++;
+        if (!hit) (is_write ? l1.write_misses : l1.read_misses)++;
+        l2_units[unit].reads += l2_cache.get_stats().reads - l2_reads;
+        l2_units[unit].read_misses += l2_cache.get_stats().read_misses - l2_read_misses;
+        analyzer.record_access(entry.address, entry.operation, total_accesses);
+        
+        if (total_accesses % 100000 == 0) {
+            std::cout << "Processed " << total_accesses << " accesses..." << std::endl;
+        }
+    });
+    if (!processed) {
+        return false;
+    }
+    
+    SamplingUnitCounts counts;
+    for (unsigned long i = 0; i < sampled; i++) {
+        counts.add(l1_units[i], l2_units[i]);
+    }
+    estimate.method = "set sampling, " + std::to_string(sampled) + " of " + std::to_string(groups) + " set groups";
+    estimate.population = groups;
+    estimate.scale = static_cast<double>(groups) / sampled;
+    finish_sampling_estimate(l1_cache, l2_cache, counts, estimate);
+    return true;
+}
+
+// SMARTS-style systematic time sampling. In every period of P accesses the last U form
+// a measured unit, preceded by W accesses of detailed warmup that run the full access
+// path with their statistics discarded. The rest are fast-forwarded by functional
+// warming (CacheT::warm), which keeps tags and replacement state current but skips
+// statistics and stream buffers; detailed warmup brings the stream buffers back in
+// step before the unit. Totals are scaled by accesses / measured.
+template <class CacheType>
+bool process_trace_time_sampled(const MappedFile& file, CacheType& l1_cache, CacheType& l2_cache,
+                                PerformanceAnalyzer& analyzer, const SimulatorOptions& options,
+                                unsigned long& total_accesses, SamplingEstimate& estimate) {
+    const unsigned long unit_size = options.sample_unit;
+    const unsigned long warmup_start = options.sample_period - options.sample_unit - options.sample_warmup;
+    const unsigned long measure_start = options.sample_period - options.sample_unit;
+    
+    using CacheStats = typename CacheType::CacheStats;
+    SamplingUnitCounts counts;
+    CacheStats measured_l1, measured_l2;
+    CacheStats unit_l1, unit_l2;    // Statistics at the start of the current unit
+    unsigned long measured_accesses = 0;
+    bool processed = for_each_trace_file_entry(file, [&](const TraceEntry& entry, uint64_t line_number, std::string_view line) {
+        if (options.verbose || total_accesses < 5) {
+            print_trace_entry(entry, line_number, line);
+        }
+        unsigned long phase = total_accesses % options.sample_period;
+        total_accesses++;
+        if (phase < warmup_start) {
+            l1_cache.warm(entry.address, entry.operation == 'w');
+            return;
+        }
+        if (phase == measure_start) {
+            unit_l1 = l1_cache.get_stats();
+            unit_l2 = l2_cache.get_stats();
+        }
+        
+        l1_cache.access_with_stats(entry.address, entry.operation == 'w');
+        if (phase >= measure_start) {
+            analyzer.record_access(entry.address, entry.operation, measured_accesses);
+            measured_accesses++;
+        }
+        if (phase + 1 == options.sample_period) {
+            CacheStats l1 = l1_cache.get_stats();
+            CacheStats l2 = l2_cache.get_stats();
+            l1.subtract(unit_l1);
+            l2.subtract(unit_l2);
+            counts.add(l1, l2);
+            measured_l1.merge(l1);
+            measured_l2.merge(l2);
+        }
+        
+        if (total_accesses % 100000 == 0) {
+            std::cout << "Processed " << total_accesses << " accesses..." << std::endl;
+        }
+    });
+    if (!processed) {
+        return false;
+    }
+    
+    if (counts.l1_accesses.empty()) {
+        std::cerr << "Error: Trace is shorter than one sampling period (" << options.sample_period
+                  << " accesses)" << std::endl;
+        return false;
+    }
+    
+    // Only measured units count; a partial last period is discarded
+    l1_cache.stats.subtract(l1_cache.get_stats());
+    l1_cache.stats.merge(measured_l1);
+    l2_cache.stats.subtract(l2_cache.get_stats());
+    l2_cache.stats.merge(measured_l2);
+    estimate.method = "time sampling, " + std::to_string(counts.l1_accesses.size()) + " units of " +
+                      std::to_string(unit_size) + " (warmup " + std::to_string(options.sample_warmup) +
+                      ", period " + std::to_string(options.sample_period) + ")";
+    estimate.population = total_accesses / unit_size;
+    estimate.scale = static_cast<double>(total_accesses) / (counts.l1_accesses.size() * unit_size);
+    finish_sampling_estimate(l1_cache, l2_cache, counts, estimate);
+    return true;
+}
+
+// Checkpoint file: a header naming the policy and the trace prefix it covers, then
+// the L1 and L2 images from CacheT::save_state. The prefix is identified by its
+// length and an FNV-1a fingerprint of its accesses, so a restore can check that it
+// replays the same trace.
+const char CHECKPOINT_MAGIC[8] = {'C', 'S', 'I', 'M', 'C', 'K', 'P', '\0'};
+const uint32_t CHECKPOINT_VERSION = 2;
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    char policy[12];
+    uint64_t accesses;         // Trace accesses simulated before the snapshot
+    uint64_t fingerprint;      // trace_fingerprint over those accesses
+};
+
+const uint64_t TRACE_FINGERPRINT_SEED = 0xcbf29ce484222325ull;
+
+inline uint64_t trace_fingerprint(uint64_t hash, const TraceEntry& entry) {
+    hash = (hash ^ entry.address) * 0x100000001b3ull;
+    return (hash ^ static_cast<unsigned char>(entry.operation)) * 0x100000001b3ull;
+}
+
+template <class CacheType>
+bool save_checkpoint(const std::string& filename, const CacheType& l1_cache, const CacheType& l2_cache,
+                     uint64_t accesses, uint64_t fingerprint) {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open checkpoint file '" << filename << "'" << std::endl;
+        return false;
+    }
+    
+    CheckpointHeader header = {};
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    strncpy(header.policy, CacheType::policy_type::name(), sizeof(header.policy) - 1);
+    header.accesses = accesses;
+    header.fingerprint = fingerprint;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    l1_cache.save_state(out);
+    l2_cache.save_state(out);
+    out.close();
+    if (!out) {
+        std::cerr << "Error: Failed writing checkpoint file '" << filename << "'" << std::endl;
+        return false;
+    }
+    std::cout << "Checkpoint saved to '" << filename << "' after " << accesses << " accesses" << std::endl;
+    return true;
+}
+
+template <class CacheType>
+bool load_checkpoint(const std::string& filename, CacheType& l1_cache, CacheType& l2_cache,
+                     CheckpointHeader& header) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Error: Cannot open checkpoint file '" << filename << "'" << std::endl;
+        return false;
+    }
+    
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+        std::cerr << "Error: '" << filename << "' is not a checkpoint file" << std::endl;
+        return false;
+    }
+    if (header.version != CHECKPOINT_VERSION) {
+        std::cerr << "Error: Unsupported checkpoint version " << header.version << std::endl;
+        return false;
+    }
+    header.policy[sizeof(header.policy) - 1] = '\0';
+    if (strcmp(header.policy, CacheType::policy_type::name()) != 0) {
+        std::cerr << "Error: Checkpoint was taken with --policy=" << header.policy << std::endl;
+        return false;
+    }
+    
+    const char* level_names[2] = {"L1", "L2"};
+    CacheType* caches[2] = {&l1_cache, &l2_cache};
+    for (int level = 0; level < 2; level++) {
+        std::string error = caches[level]->load_state(in);
+        if (!error.empty()) {
+            std::cerr << "Error: " << level_names[level] << ": " << error << std::endl;
+            return false;
+        }
+    }
+    std::cout << "Restored checkpoint '" << filename << "' taken after " << header.accesses << " accesses"
+              << std::endl;
+    return true;
+}
+
+// Process trace file and simulate cache accesses
+template <class CacheType>
+bool process_trace_file(const std::string& filename, CacheType& l1_cache, CacheType& l2_cache, 
+                       PerformanceAnalyzer& analyzer, const SimulatorOptions& options = SimulatorOptions(),
+                       MultiCoreSystem<CacheType>* multicore = nullptr, SamplingEstimate* sampling = nullptr,
+                       TimingModel<CacheType>* timing = nullptr) {
+    MappedFile file;
+    if (!open_trace_file(file, filename)) {
+        std::cerr << "Error: Cannot open trace file '" << filename << "'" << std::endl;
+        return false;
+    }
+    
+    unsigned long total_accesses = 0;
+    
+    std::cout << "Processing trace file: " << filename << std::endl;
+    std::cout << "Note: Addresses are hexadecimal, up to 64-bit (16 hex digits). Leading zeros may be omitted in trace file." << std::endl;
+    
+    // Interval rows cover the levels in use
+    std::string interval_file = options.interval_file.empty() ? filename + ".intervals.csv" : options.interval_file;
+    typename IntervalRecorder<CacheType>::Levels interval_levels = {{"l1", &l1_cache}};
+    if (l2_cache.is_enabled()) {
+        interval_levels.push_back({"l2", &l2_cache});
+    }
+    IntervalRecorder<CacheType> intervals;
+    
+    bool processed;
+    if constexpr (CacheType::policy_type::NEEDS_FUTURE) {
+        processed = process_trace_opt(file, l1_cache, analyzer, options, total_accesses);
+    } else if (multicore != nullptr) {
+        processed = process_trace_multicore(file, *multicore, l1_cache, l2_cache, analyzer, options, total_accesses);
+    } else if (sampling != nullptr && options.set_sampling > 0) {
+        processed = process_trace_set_sampled(file, l1_cache, l2_cache, analyzer, options, total_accesses, *sampling);
+    } else if (sampling != nullptr && options.sample_unit > 0) {
+        processed = process_trace_time_sampled(file, l1_cache, l2_cache, analyzer, options, total_accesses, *sampling);
+    } else if (options.pipeline_stages > 1) {
+        if (options.interval > 0 && !intervals.open(interval_file, options.interval, interval_levels, 0)) {
+            return false;
+        }
+        processed = process_trace_pipelined(file, l1_cache, analyzer, options, total_accesses, intervals);
+        processed = processed && intervals.finish(total_accesses);
+    } else if (options.threads > 1) {
+        processed = process_trace_sharded(file, l1_cache, l2_cache, analyzer, options, total_accesses);
+    } else {
+        // Checkpoint/restore: the first prefix_accesses accesses are fingerprinted, and
+        // skipped when their effect was restored from a checkpoint
+        std::string checkpoint_file = options.checkpoint_file.empty() ? filename + ".ckpt" : options.checkpoint_file;
+        CheckpointHeader restored = {};
+        if (options.restore && !load_checkpoint(checkpoint_file, l1_cache, l2_cache, restored)) {
+            return false;
+        }
+        unsigned long prefix_accesses = options.restore ? restored.accesses : options.checkpoint_at;
+        uint64_t fingerprint = TRACE_FINGERPRINT_SEED;
+        bool checkpoint_failed = false;
+        if (options.interval > 0 &&
+            !intervals.open(interval_file, options.interval, interval_levels, options.restore ? restored.accesses : 0)) {
+            return false;
+        }
+        
+        // Accesses are simulated a batch at a time (the analyzer and the progress output
+        // do not look at the caches, so they may run ahead of the batch)
+        TraceBatch pending;
+        auto simulate_pending = [&]() {
+            PROFILE_SCOPE(PROFILE_SIMULATE);
+            if (timing != nullptr) {
+                timing->access_batch(pending.entries.data(), pending.entries.size());
+            } else {
+                l1_cache.access_batch(pending.entries.data(), pending.entries.size());
+            }
+            pending.entries.clear();
+        };
+        
+        processed = for_each_trace_file_entry(file, [&](const TraceEntry& entry, uint64_t line_number, std::string_view line) {
+            if (total_accesses < prefix_accesses) {
+                fingerprint = trace_fingerprint(fingerprint, entry);
+                if (options.restore) {
+                    total_accesses++;
+                    return;
+                }
+            }
+            
+            // Show address interpretation for first few entries or if verbose
+            if (options.verbose || total_accesses < 5) {
+                print_trace_entry(entry, line_number, line);
+            }
+            
+            // Queue the cache access
+            pending.entries.push_back(entry);
+            if (pending.entries.size() == TraceBatch::CAPACITY) {
+                simulate_pending();
+            }
+            
+            // Record access for performance analysis
+            {
+                PROFILE_SCOPE(PROFILE_ANALYZE);
+                analyzer.record_access(entry.address, entry.operation, total_accesses);
+            }
+            
+            total_accesses++;
+            if (total_accesses == options.checkpoint_at) {
+                simulate_pending();
+                checkpoint_failed = !save_checkpoint(checkpoint_file, l1_cache, l2_cache, total_accesses, fingerprint);
+            }
+            if (intervals.due(total_accesses)) {
+                simulate_pending();
+                intervals.record(total_accesses);
+            }
+            
+            // Optional: Print progress for large files
+            if (total_accesses % 100000 == 0) {
+                std::cout << "Processed " << total_accesses << " accesses..." << std::endl;
+            }
+        });
+        simulate_pending();
+        processed = processed && intervals.finish(total_accesses);
+        
+        if (processed && total_accesses < prefix_accesses) {
+            std::cerr << "Error: Trace has only " << total_accesses << " accesses, the checkpoint "
+                      << (options.restore ? "covers " : "was requested at ") << prefix_accesses << std::endl;
+            processed = false;
+        } else if (processed && options.restore && fingerprint != restored.fingerprint) {
+            std::cerr << "Error: The first " << prefix_accesses << " accesses of '" << filename
+                      << "' differ from the trace the checkpoint was taken on" << std::endl;
+            processed = false;
+        }
+        processed = processed && !checkpoint_failed;
+    }
+    
+    file.close();
+    if (!processed) {
+        return false;
+    }
+    
+    std::cout << "Trace processing complete. Total accesses: " << total_accesses << std::endl;
+    if (sampling != nullptr && sampling->units > 0) {
+        std::cout << "Sampled simulation (" << sampling->method << "): statistics scaled by "
+                  << std::fixed << std::setprecision(2) << sampling->scale << std::endl;
+    }
+    return true;
+}
+
+// One flat machine-readable statistics record: ordered key/value pairs, written as a
+// JSON object on one line or as CSV (header row optional, so sweeps emit it once)
+class StatsRecord {
+private:
+    std::vector<std::string> keys;
+    std::vector<std::string> values;        // Already formatted; strings carry JSON quotes
+    std::vector<std::string> csv_values;    // Same, strings quoted per RFC 4180
+    
+    void add_number(const std::string& key, const std::string& value) {
+        keys.push_back(key);
+        values.push_back(value);
+        csv_values.push_back(value);
+    }
+    
+public:
+    void add(const std::string& key, unsigned long value) {
+        add_number(key, std::to_string(value));
+    }
+    
+    void add(const std::string& key, int value) {
+        add_number(key, std::to_string(value));
+    }
+    
+    void add(const std::string& key, double value) {
+        std::ostringstream text;
+        text << std::setprecision(10) << value;
+        add_number(key, text.str());
+    }
+    
+    // JSON escapes quotes and backslashes with a backslash; CSV doubles embedded quotes
+    void add(const std::string& key, const std::string& value) {
+        std::string json = "\"", csv = "\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') json += '\\';
+            if (c == '"') csv += '"';
+            json += c;
+            csv += c;
+        }
+        keys.push_back(key);
+        values.push_back(json + "\"");
+        csv_values.push_back(csv + "\"");
+    }
+    
+    // Every CacheStats field plus the derived rates, keys prefixed with prefix
+    template <class Stats>
+    void add_cache_stats(const std::string& prefix, const Stats& stats) {
+        stats.for_each_counter([&](const char* name, unsigned long counter) {
+            add(prefix + name, counter);
+        });
+        add(prefix + "miss_rate", stats.get_overall_miss_rate());
+        add(prefix + "read_miss_rate", stats.get_read_miss_rate());
+        add(prefix + "write_miss_rate", stats.get_write_miss_rate());
+        add(prefix + "hit_time", stats.hit_time);
+        add(prefix + "miss_penalty", stats.miss_penalty);
+        add(prefix + "aat", stats.get_aat());
+        add(prefix + "area_mm2", stats.area_mm2);
+    }
+    
+    void write(std::ostream& out, OutputFormat format, bool header = true) const {
+        if (format == OutputFormat::JSON) {
+            out << "{";
+            for (size_t i = 0; i < keys.size(); i++) {
+                out << (i > 0 ? "," : "") << "\"" << keys[i] << "\":" << values[i];
+            }
+            out << "}" << std::endl;
+            return;
+        }
+        if (header) {
+            for (size_t i = 0; i < keys.size(); i++) {
+                out << (i > 0 ? "," : "") << keys[i];
+            }
+            out << std::endl;
+        }
+        for (size_t i = 0; i < csv_values.size(); i++) {
+            out << (i > 0 ? "," : "") << csv_values[i];
+        }
+        out << std::endl;
+    }
+};
+
+// The --format record of a two-level run: geometry, every L1 and L2 statistic (L2
+// columns are zero without an L2, so CSV columns do not depend on the configuration)
+template <class CacheType>
+StatsRecord make_stats_record(const CacheType& l1_cache, const CacheType& l2_cache, int pref_n, int pref_m,
+                              const std::string& trace_file, const SimulatorOptions& options,
+                              const SamplingEstimate* sampling = nullptr) {
+    StatsRecord record;
+    record.add("blocksize", l1_cache.get_block_size());
+    record.add("l1_size", l1_cache.get_size());
+    record.add("l1_assoc", l1_cache.get_associativity());
+    record.add("l2_size", l2_cache.get_size());
+    record.add("l2_assoc", l2_cache.get_associativity());
+    record.add("pref_n", pref_n);
+    record.add("pref_m", pref_m);
+    record.add("policy", std::string(CacheType::policy_type::name()));
+    if (options.cores > 0) {
+        record.add("cores", options.cores);
+    }
+    record.add("trace", trace_file);
+    record.add_cache_stats("l1_", l1_cache.get_stats());
+    record.add_cache_stats("l2_", l2_cache.get_stats());
+    if (sampling != nullptr) {
+        record.add("l1_miss_rate_ci95", sampling->l1_half_width);
+        record.add("l2_miss_rate_ci95", sampling->l2_half_width);
+    }
+    const auto& l1_stats = l1_cache.get_stats();
+    record.add("aat", l2_cache.is_enabled() ? l1_stats.get_hierarchical_aat(l2_cache.get_stats()) : l1_stats.get_aat());
+    record.add("total_area_mm2", l1_stats.area_mm2 + l2_cache.get_stats().area_mm2);
+    return record;
+}
+
+// Three-C breakdown of one level's misses, as counts and shares of all its misses
+template <class Stats>
+void print_miss_classification(const std::string& name, const Stats& stats) {
+    unsigned long misses = stats.compulsory_misses + stats.capacity_misses + stats.conflict_misses;
+    auto row = [&](const char* label, unsigned long count) {
+        std::cout << std::setfill(' ') << std::left << std::setw(30) << (name + " " + label + ":") << std::right << count << " ("
+                  << std::fixed << std::setprecision(2) << (misses > 0 ? 100.0 * count / misses : 0.0) << "%)"
+                  << std::endl;
+    };
+    row("compulsory misses", stats.compulsory_misses);
+    row("capacity misses", stats.capacity_misses);
+    row("conflict misses", stats.conflict_misses);
+}
+
+// Print cache statistics in the required format for ECE 463
+template <class CacheType>
+void print_simulation_results(const CacheType& l1_cache, const CacheType& l2_cache,
+                              const SamplingEstimate* sampling = nullptr) {
+    std::cout << "===== Simulation results (raw) =====" << std::endl;
+    
+    const auto& l1_stats = l1_cache.get_stats();
+    
+    // L1 statistics
+    std::cout << "a. number of L1 reads:        " << l1_stats.reads << std::endl;
+    std::cout << "b. number of L1 read misses:  " << l1_stats.read_misses << std::endl;
+    std::cout << "c. number of L1 writes:       " << l1_stats.writes << std::endl;
+    std::cout << "d. number of L1 write misses: " << l1_stats.write_misses << std::endl;
+    
+    // L1 miss rate
+    double l1_miss_rate = l1_stats.get_overall_miss_rate();
+    std::cout << "e. L1 miss rate:              " << std::fixed << std::setprecision(6) << l1_miss_rate;
+    if (sampling != nullptr) {
+        std::cout << " +/- " << sampling->l1_half_width << " (95% CI)";
+    }
+    std::cout << std::endl;
+    
+    // L1 writebacks
+    std::cout << "f. number of writebacks from L1: " << l1_stats.writebacks << std::endl;
+    
+    // L1 prefetches (stream buffers sit on L1 only when it is the last level)
+    std::cout << "g. number of L1 prefetches:   " << l1_stats.prefetches << std::endl;
+    
+    if (l2_cache.is_enabled()) {
+        const auto& l2_stats = l2_cache.get_stats();
+        
+        // L2 statistics
+        std::cout << "h. number of L2 reads (demand): " << l2_stats.reads << std::endl;
+        std::cout << "i. number of L2 read misses (demand): " << l2_stats.read_misses << std::endl;
+        
+        // L2 prefetch reads (L1 never prefetches when an L2 is present)
+        std::cout << "j. number of L2 reads (prefetch): 0" << std::endl;
+        std::cout << "k. number of L2 read misses (prefetch): 0" << std::endl;
+        
+        std::cout << "l. number of L2 writes:       " << l2_stats.writes << std::endl;
+        std::cout << "m. number of L2 write misses: " << l2_stats.write_misses << std::endl;
+        
+        // L2 miss rate (from CPU perspective)
+        double l2_miss_rate = l2_stats.reads > 0 ? (double)l2_stats.read_misses / l2_stats.reads : 0.0;
+        std::cout << "n. L2 miss rate:              " << std::fixed << std::setprecision(6) << l2_miss_rate;
+        if (sampling != nullptr) {
+            std::cout << " +/- " << sampling->l2_half_width << " (95% CI)";
+        }
+        std::cout << std::endl;
+        
+        std::cout << "o. number of writebacks from L2: " << l2_stats.writebacks << std::endl;
+        
+        std::cout << "p. number of L2 prefetches:   " << l2_stats.prefetches << std::endl;
+        
+        // Total memory traffic (with L2): L2 misses, writebacks and prefetches
+        std::cout << "q. total memory traffic:      " << l2_stats.memory_traffic << std::endl;
+        
+    } else {
+        // No L2 cache - print 0s for L2 stats
+        std::cout << "h. number of L2 reads (demand): 0" << std::endl;
+        std::cout << "i. number of L2 read misses (demand): 0" << std::endl;
+        std::cout << "j. number of L2 reads (prefetch): 0" << std::endl;
+        std::cout << "k. number of L2 read misses (prefetch): 0" << std::endl;
+        std::cout << "l. number of L2 writes:       0" << std::endl;
+        std::cout << "m. number of L2 write misses: 0" << std::endl;
+        std::cout << "n. L2 miss rate:              0.000000" << std::endl;
+        std::cout << "o. number of writebacks from L2: 0" << std::endl;
+        std::cout << "p. number of L2 prefetches:   0" << std::endl;
+        
+        // Total memory traffic (without L2): L1 misses, writebacks and prefetches
+        std::cout << "q. total memory traffic:      " << l1_stats.memory_traffic << std::endl;
+    }
+    
+    std::cout << std::endl;
+    
+    // Additional performance metrics
+    std::cout << "===== Performance Metrics =====" << std::endl;
+    std::cout << "L1 Average Access Time:       " << std::fixed << std::setprecision(2) 
+              << l1_stats.get_aat() << " cycles" << std::endl;
+    std::cout << "L1 Cache Area:                " << std::fixed << std::setprecision(4) 
+              << l1_stats.area_mm2 << " mm²" << std::endl;
+    std::cout << "L1 Performance/Area:          " << std::scientific << std::setprecision(2) 
+              << l1_stats.get_performance_per_area() << " (1/cycles)/mm²" << std::endl;
+    
+    if (l2_cache.is_enabled()) {
+        const auto& l2_stats = l2_cache.get_stats();
+        std::cout << "L2 Average Access Time:       " << std::fixed << std::setprecision(2) 
+                  << l2_stats.get_aat() << " cycles" << std::endl;
+        std::cout << "L2 Cache Area:                " << std::fixed << std::setprecision(4) 
+                  << l2_stats.area_mm2 << " mm²" << std::endl;
+        std::cout << "Total Cache Area:             " << std::fixed << std::setprecision(4) 
+                  << (l1_stats.area_mm2 + l2_stats.area_mm2) << " mm²" << std::endl;
+        std::cout << "Hierarchical AAT (L1+L2+Mem): " << std::fixed << std::setprecision(2)
+                  << l1_stats.get_hierarchical_aat(l2_stats) << " cycles" << std::endl;
+    }
+    
+    std::cout << std::endl;
+    
+    if (l1_cache.classifies_misses()) {
+        std::cout << "===== Miss Classification (3C) =====" << std::endl;
+        print_miss_classification("L1", l1_stats);
+        if (l2_cache.is_enabled()) {
+            print_miss_classification("L2", l2_cache.get_stats());
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Wire L1 -> L2 -> Memory and apply the default timing parameters
+template <class CacheType>
+void connect_hierarchy(CacheType& l1_cache, CacheType& l2_cache) {
+    if (l2_cache.is_enabled()) {
+        l1_cache.set_next_level(&l2_cache);
+        // L2's next level is memory (nullptr by default)
+        l2_cache.set_timing_parameters(10, 100);  // L2: 10 cycle hit, 100 cycle miss penalty
+    } else {
+        // No L2 cache, L1 goes directly to memory (nullptr by default)
+    }
+    
+    // Set L1 timing parameters
+    l1_cache.set_timing_parameters(1, l2_cache.is_enabled() ? 10 : 100);  // L1: 1 cycle hit, miss penalty depends on L2
+}
+
+// One cache level of a hierarchy description
+struct CacheLevelConfig {
+    int size;
+    int assoc;
+    int hit_latency;             // Cycles
+    InclusionPolicy inclusion;   // Relative to the level above
+};
+
+// An N-level hierarchy read from a text file, one directive per line ('#' comments):
+//   blocksize <bytes>
+//   memory_latency <cycles>                      (default 100)
+//   prefetch <PREF_N> <PREF_M>                   (stream buffers on the last level)
+//   level <size> <assoc> <hit_cycles> [nine|inclusive|exclusive]
+// Levels are listed from L1 outwards; inclusion defaults to nine.
+struct HierarchyConfig {
+    int block_size;
+    int memory_latency;
+    int pref_n;
+    int pref_m;
+    std::vector<CacheLevelConfig> levels;
+    
+    HierarchyConfig() : block_size(0), memory_latency(100), pref_n(0), pref_m(0) {}
+};
+
+// Parse a hierarchy file; false with a message in error on failure
+bool load_hierarchy_config(const std::string& filename, HierarchyConfig& config, std::string& error) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        error = "Cannot open hierarchy file '" + filename + "'";
+        return false;
+    }
+    
+    std::string line;
+    int line_number = 0;
     while (std::getline(file, line)) {
         line_number++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string directive;
+        if (!(fields >> directive)) {
+            continue;
+        }
         
-        // Skip empty lines and comments
-        if (line.empty() || line[0] == '#') {
+        bool ok;
+        if (directive == "blocksize") {
+            ok = static_cast<bool>(fields >> config.block_size);
+        } else if (directive == "memory_latency") {
+            ok = static_cast<bool>(fields >> config.memory_latency) && config.memory_latency >= 0;
+        } else if (directive == "prefetch") {
+            ok = static_cast<bool>(fields >> config.pref_n >> config.pref_m);
+        } else if (directive == "level") {
+            CacheLevelConfig level = {0, 0, 0, InclusionPolicy::NINE};
+            std::string inclusion = "nine";
+            ok = static_cast<bool>(fields >> level.size >> level.assoc >> level.hit_latency) && level.hit_latency >= 0;
+            fields >> inclusion;
+            if (inclusion == "inclusive") {
+                level.inclusion = InclusionPolicy::INCLUSIVE;
+            } else if (inclusion == "exclusive") {
+                level.inclusion = InclusionPolicy::EXCLUSIVE;
+            } else if (inclusion != "nine") {
+                ok = false;
+            }
+            config.levels.push_back(level);
+        } else {
+            ok = false;
+        }
+        
+        std::string extra;
+        if (!ok || fields >> extra) {
+            error = filename + ":" + std::to_string(line_number) + ": invalid line '" + line + "'";
+            return false;
+        }
+    }
+    
+    if (config.block_size <= 0) {
+        error = "Hierarchy file must set a positive blocksize";
+    } else if (config.levels.empty()) {
+        error = "Hierarchy file must define at least one level";
+    } else if (config.levels[0].inclusion != InclusionPolicy::NINE) {
+        error = "L1 has no level above it to include or exclude";
+    } else if (config.pref_n < 0 || config.pref_m < 0 || (config.pref_n > 0 && config.pref_m == 0)) {
+        error = "prefetch needs PREF_N >= 0 and, when PREF_N > 0, PREF_M > 0";
+    } else if (config.pref_n > 0 && config.levels.back().inclusion == InclusionPolicy::EXCLUSIVE) {
+        error = "Stream buffers cannot sit on an exclusive last level";
+    } else {
+        return true;
+    }
+    return false;
+}
+
+// Caches of an N-level hierarchy, L1 first, wired to each other and to memory
+template <class CacheType>
+class CacheHierarchy {
+private:
+    std::vector<std::unique_ptr<CacheType>> levels;
+    std::vector<InclusionPolicy> inclusions;
+    int memory_latency;
+    
+public:
+    explicit CacheHierarchy(const HierarchyConfig& config) : memory_latency(config.memory_latency) {
+        for (const CacheLevelConfig& level : config.levels) {
+            levels.push_back(std::make_unique<CacheType>(config.block_size, level.size, level.assoc));
+            levels.back()->set_inclusion(level.inclusion);
+            inclusions.push_back(level.inclusion);
+        }
+        for (size_t k = 0; k < levels.size(); k++) {
+            int miss_penalty = k + 1 < levels.size() ? config.levels[k + 1].hit_latency : memory_latency;
+            levels[k]->set_timing_parameters(config.levels[k].hit_latency, miss_penalty);
+            if (k + 1 < levels.size()) {
+                levels[k]->set_next_level(levels[k + 1].get());
+            }
+        }
+        levels.back()->set_prefetcher(config.pref_n, config.pref_m);
+    }
+    
+    // First invalid level's configuration error, or "" when all are valid
+    std::string get_config_error() const {
+        for (size_t k = 0; k < levels.size(); k++) {
+            const CacheType& level = *levels[k];
+            std::string error = !level.is_enabled() ? "Cache size must be positive" : level.get_config_error();
+            if (!error.empty()) {
+                return level_name(k) + ": " + error;
+            }
+        }
+        return "";
+    }
+    
+    bool access(unsigned long address, bool is_write) {
+        return levels.front()->access_with_stats(address, is_write);
+    }
+    
+    size_t depth() const { return levels.size(); }
+    CacheType& level(size_t k) { return *levels[k]; }
+    const CacheType& level(size_t k) const { return *levels[k]; }
+    static std::string level_name(size_t k) { return "L" + std::to_string(k + 1); }
+    
+    // AAT seen by the CPU, built from memory upwards: each level contributes its hit
+    // time plus its miss rate times the AAT of everything below it. L1 uses its overall
+    // miss rate; lower levels use their demand-read (fetch) miss rate, as
+    // CacheStats::get_hierarchical_aat does for two levels.
+    double get_aat() const {
+        double below = memory_latency;
+        for (size_t k = levels.size(); k-- > 0;) {
+            const auto& stats = levels[k]->get_stats();
+            double miss_rate = k == 0 ? stats.get_overall_miss_rate() : stats.get_read_miss_rate();
+            below = stats.hit_time + miss_rate * below;
+        }
+        return below;
+    }
+    
+    double get_total_area() const {
+        double area = 0.0;
+        for (const auto& level : levels) {
+            area += level->get_stats().area_mm2;
+        }
+        return area;
+    }
+};
+
+// One cache hierarchy simulated by sweep mode
+struct SweepPoint {
+    int l1_size;
+    int l1_assoc;
+    bool l1_fully_associative;   // Requested as "full": assoc = number of blocks
+    int l2_size;
+    int l2_assoc;
+    Cache l1_cache;
+    Cache l2_cache;
+    
+    SweepPoint(int bs, int l1_s, int l1_a, bool l1_full, int l2_s, int l2_a, StorageArena* arena)
+        : l1_size(l1_s), l1_assoc(l1_a), l1_fully_associative(l1_full),
+          l2_size(l2_s), l2_assoc(l2_a),
+          l1_cache(bs, l1_s, l1_a, nullptr, arena), l2_cache(bs, l2_s, l2_a, nullptr, arena) {
+        connect_hierarchy(l1_cache, l2_cache);
+    }
+};
+
+// Parse a comma-separated list of sizes/associativities ("1024,2048" or "1,2,full").
+// "full" (or "fully") is returned as 0 and means fully-associative.
+bool parse_sweep_list(const std::string& text, std::vector<int>& values, bool allow_full) {
+    std::istringstream iss(text);
+    std::string item;
+    values.clear();
+    
+    while (std::getline(iss, item, ',')) {
+        if (allow_full && (item == "full" || item == "fully")) {
+            values.push_back(0);
             continue;
         }
-        
-        TraceEntry entry('r', 0);
-        if (!parse_trace_line(line, entry)) {
-            std::cerr << "Warning: Invalid trace format at line " << line_number 
-                      << ": '" << line << "'" << std::endl;
-            continue;
+        try {
+            size_t consumed = 0;
+            int value = std::stoi(item, &consumed);
+            if (consumed != item.length() || value < 0) {
+                return false;
+            }
+            values.push_back(value);
+        } catch (const std::exception&) {
+            return false;
         }
+    }
+    return !values.empty();
+}
+
+// One CSV row of sweep output, produced either by simulation or by an analytic engine
+struct SweepResult {
+    int l1_size;
+    int l1_assoc;
+    bool l1_fully_associative;
+    int l2_size;
+    int l2_assoc;
+    Cache::CacheStats l1_stats;
+    Cache::CacheStats l2_stats;
+};
+
+// Miss rate CSV in the layout produced by run_enhanced_experiment.sh, plus L2 columns
+void write_sweep_csv(std::ostream& out, const std::vector<SweepResult>& results) {
+    out << "log2_size,size_kb,associativity,miss_rate,aat_cycles,area_mm2,performance_per_area,"
+        << "l2_size_kb,l2_associativity,l2_miss_rate" << std::endl;
+    
+    for (const auto& result : results) {
+        const auto& l1_stats = result.l1_stats;
+        const auto& l2_stats = result.l2_stats;
+        // Performance per area uses the same hierarchical AAT as aat_cycles, over L1+L2 area
+        double aat = result.l2_size > 0 ? l1_stats.get_hierarchical_aat(l2_stats) : l1_stats.get_aat();
+        double total_area = l1_stats.area_mm2 + (result.l2_size > 0 ? l2_stats.area_mm2 : 0.0);
+        double performance_per_area = aat > 0.0 && total_area > 0.0 ? (1.0 / aat) / total_area : 0.0;
         
-        // Show address interpretation for first few entries or if verbose
-        if (verbose || total_accesses < 5) {
-            std::cout << "Line " << line_number << ": " << entry.operation 
-                      << " " << entry.get_formatted_address() 
-                      << " (from: " << line << ")" << std::endl;
+        out << static_cast<int>(log2(result.l1_size)) << ",";
+        if (result.l1_size % 1024 == 0) {
+            out << result.l1_size / 1024 << ",";
+        } else {
+            out << result.l1_size / 1024.0 << ",";
         }
+        if (result.l1_fully_associative) {
+            out << "fully,";
+        } else {
+            out << result.l1_assoc << ",";
+        }
+        out << std::fixed << std::setprecision(6) << l1_stats.get_overall_miss_rate() << ","
+            << std::fixed << std::setprecision(2)
+            << aat << ","
+            << std::fixed << std::setprecision(4) << l1_stats.area_mm2 << ","
+            << std::scientific << std::setprecision(2) << performance_per_area << ",";
+        out << std::defaultfloat;
         
-        // Process the cache access
+        if (result.l2_size > 0) {
+            double l2_miss_rate = l2_stats.reads > 0 ? (double)l2_stats.read_misses / l2_stats.reads : 0.0;
+            if (result.l2_size % 1024 == 0) {
+                out << result.l2_size / 1024 << ",";
+            } else {
+                out << result.l2_size / 1024.0 << ",";
+            }
+            out << result.l2_assoc << ","
+                << std::fixed << std::setprecision(6) << l2_miss_rate << std::defaultfloat;
+        } else {
+            out << "0,0," << std::fixed << std::setprecision(6) << 0.0 << std::defaultfloat;
+        }
+        out << std::endl;
+    }
+}
+
+// --format=json|csv sweep output: one full-statistics record per configuration
+void write_sweep_records(std::ostream& out, const std::vector<SweepResult>& results, int blocksize,
+                         OutputFormat format) {
+    for (size_t i = 0; i < results.size(); i++) {
+        const SweepResult& result = results[i];
+        StatsRecord record;
+        record.add("blocksize", blocksize);
+        record.add("l1_size", result.l1_size);
+        record.add("l1_assoc", result.l1_assoc);
+        record.add("l1_fully_associative", result.l1_fully_associative ? 1 : 0);
+        record.add("l2_size", result.l2_size);
+        record.add("l2_assoc", result.l2_assoc);
+        record.add_cache_stats("l1_", result.l1_stats);
+        record.add_cache_stats("l2_", result.l2_stats);
+        record.add("aat", result.l2_size > 0 ? result.l1_stats.get_hierarchical_aat(result.l2_stats)
+                                              : result.l1_stats.get_aat());
+        record.add("total_area_mm2", result.l1_stats.area_mm2 + result.l2_stats.area_mm2);
+        record.write(out, format, i == 0);
+    }
+}
+
+// Write sweep results to the named file, or to stdout when no file is given
+bool save_sweep_results(const std::vector<SweepResult>& results, const char* output_file, int blocksize,
+                        OutputFormat format) {
+    auto write = [&](std::ostream& out) {
+        if (format == OutputFormat::TEXT) {
+            write_sweep_csv(out, results);
+        } else {
+            write_sweep_records(out, results, blocksize, format);
+        }
+    };
+    if (output_file == nullptr) {
+        write(std::cout);
+        return true;
+    }
+    
+    std::ofstream out(output_file);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open output file '" << output_file << "'" << std::endl;
+        return false;
+    }
+    write(out);
+    std::cerr << "Results saved to: " << output_file << std::endl;
+    return true;
+}
+
+// Sweep mode: simulate every (L1, L2) geometry of the cross product in a single trace pass
+int run_sweep(int argc, char* argv[]) {
+    OutputFormat format = OutputFormat::TEXT;
+    if (!extract_output_format(argc, argv, format)) {
+        return 1;
+    }
+    if (argc != 8 && argc != 9) {
+        std::cerr << "Usage: " << argv[0] << " --sweep <BLOCKSIZE> <L1_SIZES> <L1_ASSOCS> <L2_SIZES> <L2_ASSOCS> <trace_file> [output_csv] [--format=json|csv]" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "  Lists are comma-separated, e.g. 1024,2048,4096 and 1,2,4,8,full" << std::endl;
+        std::cerr << "  \"full\" selects a fully-associative L1 (associativity = number of blocks)" << std::endl;
+        std::cerr << "  L2_SIZES of 0 disables L2; one CSV row is written per configuration" << std::endl;
+        std::cerr << "  --format=json|csv writes every statistic per configuration instead" << std::endl;
+        return 1;
+    }
+    
+    int blocksize = std::atoi(argv[2]);
+    std::vector<int> l1_sizes, l1_assocs, l2_sizes, l2_assocs;
+    if (!parse_sweep_list(argv[3], l1_sizes, false) ||
+        !parse_sweep_list(argv[4], l1_assocs, true) ||
+        !parse_sweep_list(argv[5], l2_sizes, false) ||
+        !parse_sweep_list(argv[6], l2_assocs, false)) {
+        std::cerr << "Error: Invalid sweep list (expected comma-separated non-negative integers)" << std::endl;
+        return 1;
+    }
+    std::string trace_file = argv[7];
+    
+    if (blocksize <= 0) {
+        std::cerr << "Error: BLOCKSIZE must be a positive integer" << std::endl;
+        return 1;
+    }
+    
+    // Build the cross product of all requested geometries, their storage packed into
+    // shared arena chunks rather than allocated cache by cache
+    StorageArena arena;
+    std::vector<std::unique_ptr<SweepPoint>> points;
+    for (int l1_size : l1_sizes) {
+        for (int l1_assoc : l1_assocs) {
+            bool fully = (l1_assoc == 0);
+            int assoc = fully ? l1_size / blocksize : l1_assoc;
+            for (int l2_size : l2_sizes) {
+                for (size_t k = 0; k < l2_assocs.size(); k++) {
+                    // L2 associativity is irrelevant when L2 is disabled
+                    if (l2_size == 0 && k > 0) break;
+                    int l2_assoc = l2_size == 0 ? 0 : l2_assocs[k];
+                    points.push_back(std::make_unique<SweepPoint>(blocksize, l1_size, assoc, fully,
+                                                                  l2_size, l2_assoc, &arena));
+                    const SweepPoint& point = *points.back();
+                    if (!point.l1_cache.is_enabled() || !point.l1_cache.is_valid_configuration()) {
+                        std::cerr << "Error: Invalid L1 cache configuration (" << l1_size << " bytes, "
+                                  << assoc << "-way) - "
+                                  << (point.l1_cache.is_enabled() ? point.l1_cache.get_config_error()
+                                                                  : "Cache size must be positive")
+                                  << std::endl;
+                        return 1;
+                    }
+                    if (!point.l2_cache.is_valid_configuration()) {
+                        std::cerr << "Error: Invalid L2 cache configuration (" << l2_size << " bytes, "
+                                  << l2_assoc << "-way) - " << point.l2_cache.get_config_error() << std::endl;
+                        return 1;
+                    }
+                }
+            }
+        }
+    }
+    
+    MappedFile file;
+    if (!open_trace_file(file, trace_file)) {
+        std::cerr << "Error: Cannot open trace file '" << trace_file << "'" << std::endl;
+        return 1;
+    }
+    
+    // JSON/CSV records carry every counter, so their misses are classified (3C); the
+    // fixed miss-rate CSV layout has no columns for it. Every L1 sees the whole trace,
+    // so the L1s of one capacity share a shadow and all of them one first-touch set;
+    // each L2 sees its own L1's misses and classifies them itself.
+    bool classify = (format != OutputFormat::TEXT);
+    std::vector<std::unique_ptr<FullyAssociativeLru>> shadows;
+    std::vector<size_t> shadow_of(points.size());
+    std::vector<char> shadow_hits;
+    BlockSet seen;
+    if (classify) {
+        std::unordered_map<int, size_t> by_capacity;
+        for (size_t i = 0; i < points.size(); i++) {
+            int blocks = points[i]->l1_cache.get_num_blocks();
+            auto found = by_capacity.find(blocks);
+            if (found == by_capacity.end()) {
+                found = by_capacity.emplace(blocks, shadows.size()).first;
+                shadows.push_back(std::make_unique<FullyAssociativeLru>(blocks));
+            }
+            shadow_of[i] = found->second;
+            points[i]->l2_cache.classify_misses();
+        }
+        shadow_hits.resize(shadows.size());
+    }
+    
+    std::cerr << "Sweeping " << points.size() << " configurations over trace file: " << trace_file << std::endl;
+    
+    // Each decoded access is fed to every configuration before reading the next line
+    unsigned long total_accesses = 0;
+    bool processed = for_each_trace_file_entry(file, [&](const TraceEntry& entry, uint64_t, std::string_view) {
         bool is_write = (entry.operation == 'w');
-        bool l1_hit = l1_cache.access_with_stats(entry.address, is_write);
-        
-        // Record access for performance analysis
-        analyzer.record_access(entry.address, entry.operation, total_accesses);
-        
+        if (!classify) {
+            for (auto& point : points) {
+                point->l1_cache.access_with_stats(entry.address, is_write);
+            }
+        } else {
+            uint64_t block = entry.address / blocksize;
+            bool all_hit = true;
+            for (size_t g = 0; g < shadows.size(); g++) {
+                shadow_hits[g] = shadows[g]->access(block);
+                all_hit &= shadow_hits[g];
+            }
+            bool first = !all_hit && seen.insert(block);
+            for (size_t i = 0; i < points.size(); i++) {
+                bool hit = points[i]->l1_cache.access_with_stats(entry.address, is_write);
+                points[i]->l1_cache.count_miss_class(MissClassifier::classify(hit, shadow_hits[shadow_of[i]], first));
+            }
+        }
+        total_accesses++;
+    });
+    if (!processed) {
+        return 1;
+    }
+    
+    std::cerr << "Sweep complete. Total accesses: " << total_accesses << std::endl;
+    
+    std::vector<SweepResult> results;
+    for (const auto& point : points) {
+        results.push_back({point->l1_size, point->l1_assoc, point->l1_fully_associative,
+                           point->l2_size, point->l2_assoc,
+                           point->l1_cache.get_stats(), point->l2_cache.get_stats()});
+    }
+    
+    if (!save_sweep_results(results, argc == 9 ? argv[8] : nullptr, blocksize, format)) {
+        return 1;
+    }
+    
+    return 0;
+}
+
+// Stack-distance mode: the whole LRU miss-rate-vs-size curve of an L1-only hierarchy from one pass
+int run_stack_distance(int argc, char* argv[]) {
+    OutputFormat format = OutputFormat::TEXT;
+    if (!extract_output_format(argc, argv, format)) {
+        return 1;
+    }
+    if (argc != 6 && argc != 7) {
+        std::cerr << "Usage: " << argv[0] << " --stack-distance <BLOCKSIZE> <L1_SIZES> <L1_ASSOCS> <trace_file> [output_csv] [--format=json|csv]" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "  Lists are comma-separated, e.g. 1024,2048,4096 and 1,2,4,8,full" << std::endl;
+        std::cerr << "  Produces the same CSV as --sweep for LRU L1-only configurations" << std::endl;
+        return 1;
+    }
+    
+    int blocksize = std::atoi(argv[2]);
+    std::vector<int> l1_sizes, l1_assocs;
+    if (!parse_sweep_list(argv[3], l1_sizes, false) || !parse_sweep_list(argv[4], l1_assocs, true)) {
+        std::cerr << "Error: Invalid sweep list (expected comma-separated non-negative integers)" << std::endl;
+        return 1;
+    }
+    std::string trace_file = argv[5];
+    
+    if (blocksize <= 0) {
+        std::cerr << "Error: BLOCKSIZE must be a positive integer" << std::endl;
+        return 1;
+    }
+    
+    // Validate every geometry and collect the deepest associativity needed per set count
+    std::vector<SweepResult> results;
+    std::vector<int> set_counts, max_assocs;
+    for (int l1_size : l1_sizes) {
+        for (int l1_assoc : l1_assocs) {
+            bool fully = (l1_assoc == 0);
+            int assoc = fully ? l1_size / blocksize : l1_assoc;
+            
+            Cache cache(blocksize, l1_size, assoc);
+            if (!cache.is_enabled() || !cache.is_valid_configuration()) {
+                std::cerr << "Error: Invalid L1 cache configuration (" << l1_size << " bytes, "
+                          << assoc << "-way) - "
+                          << (cache.is_enabled() ? cache.get_config_error() : "Cache size must be positive")
+                          << std::endl;
+                return 1;
+            }
+            
+            SweepResult result = {l1_size, assoc, fully, 0, 0, Cache::CacheStats(), Cache::CacheStats()};
+            result.l1_stats.area_mm2 = cache.calculate_area();
+            results.push_back(result);
+            
+            auto it = std::find(set_counts.begin(), set_counts.end(), cache.get_num_sets());
+            if (it == set_counts.end()) {
+                set_counts.push_back(cache.get_num_sets());
+                max_assocs.push_back(assoc);
+            } else {
+                int& depth = max_assocs[it - set_counts.begin()];
+                depth = std::max(depth, assoc);
+            }
+        }
+    }
+    
+    MappedFile file;
+    if (!open_trace_file(file, trace_file)) {
+        std::cerr << "Error: Cannot open trace file '" << trace_file << "'" << std::endl;
+        return 1;
+    }
+    
+    std::cerr << "Profiling stack distances for " << set_counts.size() << " set counts ("
+              << results.size() << " configurations) over trace file: " << trace_file << std::endl;
+    
+    StackDistanceAnalyzer profiler(blocksize, set_counts, max_assocs);
+    unsigned long total_accesses = 0;
+    bool processed = for_each_trace_file_entry(file, [&](const TraceEntry& entry, uint64_t, std::string_view) {
+        profiler.record_access(entry.address, entry.operation == 'w');
         total_accesses++;
+    });
+    if (!processed) {
+        return 1;
+    }
+    
+    std::cerr << "Profiling complete. Total accesses: " << total_accesses << std::endl;
+    
+    for (auto& result : results) {
+        double area = result.l1_stats.area_mm2;
+        int num_sets = result.l1_size / blocksize / result.l1_assoc;
+        result.l1_stats = profiler.get_stats(num_sets, result.l1_assoc);
+        result.l1_stats.area_mm2 = area;
+    }
+    
+    if (!save_sweep_results(results, argc == 7 ? argv[6] : nullptr, blocksize, format)) {
+        return 1;
+    }
+    
+    return 0;
+}
+
+// Convert mode: re-encode a text (or binary) trace into the compact binary format
+int run_convert(int argc, char* argv[]) {
+    if (argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " convert <input_trace> <output_binary_trace>" << std::endl;
+        return 1;
+    }
+    
+    MappedFile input;
+    if (!input.open(argv[2])) {
+        std::cerr << "Error: Cannot open trace file '" << argv[2] << "'" << std::endl;
+        return 1;
+    }
+    
+    // Opening the output truncates it, which would corrupt an input that is still mapped
+    struct stat input_info, output_info;
+    if (stat(argv[2], &input_info) == 0 && stat(argv[3], &output_info) == 0 &&
+        input_info.st_dev == output_info.st_dev && input_info.st_ino == output_info.st_ino) {
+        std::cerr << "Error: Output file '" << argv[3] << "' is the same file as the input" << std::endl;
+        return 1;
+    }
+    
+    std::ofstream output(argv[3], std::ios::binary);
+    if (!output.is_open()) {
+        std::cerr << "Error: Cannot open output file '" << argv[3] << "'" << std::endl;
+        return 1;
+    }
+    
+    // Header is rewritten with the final record count once all records are out
+    BinaryTraceHeader header;
+    memcpy(header.magic, BINARY_TRACE_MAGIC, sizeof(header.magic));
+    header.version = BINARY_TRACE_VERSION;
+    header.encoding = BINARY_TRACE_DELTA_VARINT;
+    header.record_count = 0;
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    
+    std::vector<unsigned char> buffer;
+    buffer.reserve(1 << 20);
+    unsigned long previous = 0;
+    // Records hold only the address and a write bit, so core tags and instruction
+    // fetches cannot be represented; such traces are rejected rather than flattened
+    uint64_t unsupported_line = 0;
+    
+    bool processed = for_each_trace_file_entry(input, [&](const TraceEntry& entry, uint64_t line_number, std::string_view) {
+        if (unsupported_line != 0 || entry.core != 0 || entry.operation == 'i') {
+            unsupported_line = unsupported_line != 0 ? unsupported_line : line_number;
+            return;
+        }
+        unsigned char record[16];
+        size_t n = encode_binary_record(entry.address, entry.operation == 'w', previous, record);
+        buffer.insert(buffer.end(), record, record + n);
+        previous = entry.address;
+        header.record_count++;
         
-        // Optional: Print progress for large files
-        if (total_accesses % 100000 == 0) {
-            std::cout << "Processed " << total_accesses << " accesses..." << std::endl;
+        if (buffer.size() >= (1 << 20)) {
+            output.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+            buffer.clear();
         }
+    });
+    if (!processed) {
+        return 1;
     }
+    if (unsupported_line != 0) {
+        output.close();
+        std::remove(argv[3]);
+        std::cerr << "Error: Line " << unsupported_line << " has a core tag or an instruction fetch, "
+                  << "which the binary format cannot store; simulate the text trace directly" << std::endl;
+        return 1;
+    }
+    output.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
     
-    file.close();
+    output.seekp(0);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.seekp(0, std::ios::end);
+    unsigned long output_size = static_cast<unsigned long>(output.tellp());
+    output.close();
+    if (!output) {
+        std::cerr << "Error: Failed writing output file '" << argv[3] << "'" << std::endl;
+        return 1;
+    }
     
-    std::cout << "Trace processing complete. Total accesses: " << total_accesses << std::endl;
-    return true;
+    std::cout << "Converted " << header.record_count << " accesses: " << input.size() << " bytes -> "
+              << output_size << " bytes (" << std::fixed << std::setprecision(2)
+              << (header.record_count > 0 ? (double)output_size / header.record_count : 0.0)
+              << " bytes/access)" << std::endl;
+    return 0;
 }
 
-// Print cache statistics in the required format for ECE 463
-void print_simulation_results(const Cache& l1_cache, const Cache& l2_cache) {
-    std::cout << "===== Simulation results (raw) =====" << std::endl;
+// Index mode: build (or refresh) the decoded index of a trace and print its summary
+int run_index(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " index <trace_file>" << std::endl;
+        return 1;
+    }
     
-    const auto& l1_stats = l1_cache.get_stats();
+    std::string trace_file = argv[2];
+    DecodedTraceHeader header;
+    if (!ensure_decoded_trace(trace_file, header)) {
+        std::cerr << "Error: Cannot index trace file '" << trace_file << "' (must be a readable regular file)"
+                  << std::endl;
+        return 1;
+    }
     
-    // L1 statistics
-    std::cout << "a. number of L1 reads:        " << l1_stats.reads << std::endl;
-    std::cout << "b. number of L1 read misses:  " << l1_stats.read_misses << std::endl;
-    std::cout << "c. number of L1 writes:       " << l1_stats.writes << std::endl;
-    std::cout << "d. number of L1 write misses: " << l1_stats.write_misses << std::endl;
+    std::cout << "Decoded trace index: " << decoded_trace_path(trace_file) << std::endl;
+    std::cout << "Accesses:            " << header.record_count << " (" << header.reads << " reads, "
+              << header.writes << " writes, " << header.fetches << " fetches)" << std::endl;
+    std::cout << "Core tags:           " << ((header.flags & DECODED_TRACE_CORES) ? "yes" : "no") << std::endl;
+    std::cout << "Address range:       " << std::hex << std::setfill('0') << std::setw(8) << header.min_address
+              << " - " << std::setw(8) << header.max_address << std::dec << std::setfill(' ') << std::endl;
+    std::cout << std::endl;
+    std::cout << "Block size  Unique blocks  Footprint (bytes)" << std::endl;
+    for (int k = 0; k < DECODED_TRACE_BLOCK_BITS; k++) {
+        std::cout << std::setw(10) << (1 << k) << "  " << std::setw(13) << header.unique_blocks[k] << "  "
+                  << std::setw(17) << (header.unique_blocks[k] << k) << std::endl;
+    }
+    return 0;
+}
+
+// One access of a trace decoded into memory, shared read-only by the DSE workers
+struct DecodedAccess {
+    unsigned long address;
+    char operation;
+};
+
+// One design point of --dse. Area is known from the geometry alone, so candidates
+// are sorted and pruned by it before anything is simulated.
+struct DsePoint {
+    int blocksize;
+    int l1_size;
+    int l1_assoc;
+    int l2_size;
+    int l2_assoc;
+    int pref_n;
+    int pref_m;
+    double area;
+    bool evaluated;
+    Cache::CacheStats l1_stats;
+    Cache::CacheStats l2_stats;
+    double aat;
+};
+
+// Copy statistics between the (distinct but identical) CacheStats types of two policies
+template <class From, class To>
+void copy_stats(const From& from, To& to) {
+    unsigned long counters[32];
+    size_t count = 0;
+    from.for_each_counter([&](const char*, unsigned long counter) { counters[count++] = counter; });
+    count = 0;
+    to.for_each_counter([&](const char*, unsigned long& counter) { counter = counters[count++]; });
+    to.hit_time = from.hit_time;
+    to.miss_penalty = from.miss_penalty;
+    to.area_mm2 = from.area_mm2;
+}
+
+// Evaluate candidates in increasing area on a pool of worker threads and keep those
+// no evaluated point dominates (area <= and AAT <=). With L1 (1 cycle) missing to L2
+// (10 cycles) missing to memory (100 cycles), and every L1 miss reading L2 once,
+//   AAT = 1 + 10 * L1 misses / accesses + 100 * L2 read misses / accesses
+// (L1-only: 1 + 100 * L1 misses / accesses). The counters only grow, so partial
+// counts bound the final AAT from below, as do:
+//   - compulsory misses: every distinct block misses L1 and, without stream buffers,
+//     the last level;
+//   - with an L2, the exact miss rate of an already simulated point with the same L1
+//     (the L1 never sees the L2 or the prefetcher, so its misses do not change).
+// A candidate is dropped before or during its simulation (checked every
+// PRUNE_INTERVAL accesses) once a design no larger has an AAT within its bound,
+// which prunes whole ranges of larger L2s behind one good smaller design.
+template <class Policy>
+void run_dse_search(std::vector<DsePoint>& points, const std::vector<DecodedAccess>& trace,
+                    const std::unordered_map<int, unsigned long>& unique_blocks, int threads,
+                    unsigned long& pruned_early, unsigned long& pruned_late) {
+    using CacheType = CacheT<Policy>;
+    struct L1Key {
+        int blocksize, size, assoc;
+        bool operator==(const L1Key& other) const {
+            return blocksize == other.blocksize && size == other.size && assoc == other.assoc;
+        }
+    };
+    struct L1KeyHash {
+        size_t operator()(const L1Key& key) const {
+            return (static_cast<size_t>(key.blocksize) * 1000003u + key.size) * 1000003u + key.assoc;
+        }
+    };
+    const size_t PRUNE_INTERVAL = 1 << 18;
     
-    // L1 miss rate
-    double l1_miss_rate = l1_stats.get_overall_miss_rate();
-    std::cout << "e. L1 miss rate:              " << std::fixed << std::setprecision(6) << l1_miss_rate << std::endl;
+    std::mutex mutex;
+    std::vector<size_t> done;                                  // Evaluated points, by index
+    std::unordered_map<L1Key, double, L1KeyHash> l1_miss_rate;  // L1s measured behind an L2
+    std::atomic<size_t> next(0);
+    pruned_early = 0;
+    pruned_late = 0;
+    const double accesses = std::max<double>(trace.size(), 1.0);
+    
+    // Caller holds mutex
+    auto dominated = [&](const DsePoint& point, double bound) {
+        for (size_t j : done) {
+            if (points[j].area <= point.area && points[j].aat <= bound) {
+                return true;
+            }
+        }
+        return false;
+    };
+    
+    auto worker = [&]() {
+        for (size_t i = next++; i < points.size(); i = next++) {
+            DsePoint& point = points[i];
+            L1Key l1_key = {point.blocksize, point.l1_size, point.l1_assoc};
+            double compulsory = unique_blocks.at(point.blocksize) / accesses;
+            double l1_floor = compulsory;
+            double last_floor = point.pref_n > 0 ? 0.0 : compulsory;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto known = l1_miss_rate.find(l1_key);
+                if (point.l2_size > 0 && known != l1_miss_rate.end()) {
+                    l1_floor = known->second;
+                }
+            }
+            
+            CacheType l2_cache(point.blocksize, point.l2_size, point.l2_assoc);
+            CacheType l1_cache(point.blocksize, point.l1_size, point.l1_assoc);
+            connect_hierarchy(l1_cache, l2_cache);
+            (l2_cache.is_enabled() ? l2_cache : l1_cache).set_prefetcher(point.pref_n, point.pref_m);
+            
+            bool pruned = false;
+            for (size_t first = 0; first < trace.size() || first == 0; first += PRUNE_INTERVAL) {
+                const auto& l1 = l1_cache.get_stats();
+                const auto& l2 = l2_cache.get_stats();
+                double l1_misses = std::max((l1.read_misses + l1.write_misses) / accesses, l1_floor);
+                double bound = point.l2_size > 0
+                    ? 1.0 + 10.0 * l1_misses + 100.0 * std::max(l2.read_misses / accesses, last_floor)
+                    : 1.0 + 100.0 * std::max((l1.read_misses + l1.write_misses) / accesses, last_floor);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (dominated(point, bound)) {
+                        (first == 0 ? pruned_early : pruned_late)++;
+                        pruned = true;
+                        break;
+                    }
+                }
+                if (first >= trace.size()) break;
+                l1_cache.access_batch(trace.data() + first, std::min(PRUNE_INTERVAL, trace.size() - first));
+            }
+            if (pruned) {
+                continue;
+            }
+            
+            std::lock_guard<std::mutex> lock(mutex);
+            copy_stats(l1_cache.get_stats(), point.l1_stats);
+            copy_stats(l2_cache.get_stats(), point.l2_stats);
+            point.aat = l2_cache.is_enabled() ? point.l1_stats.get_hierarchical_aat(point.l2_stats)
+                                              : point.l1_stats.get_aat();
+            point.evaluated = true;
+            done.push_back(i);
+            if (point.l2_size > 0) {
+                l1_miss_rate[l1_key] = point.l1_stats.get_overall_miss_rate();
+            }
+        }
+    };
+    
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+// Design-space exploration: the AAT vs area Pareto front over the cross product of
+// parameter lists, from one in-memory decode of the trace
+int run_dse(int argc, char* argv[]) {
+    OutputFormat format = OutputFormat::CSV;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    double area_budget = 0.0;
+    ReplacementPolicy policy = ReplacementPolicy::LRU;
+    std::vector<char*> positional = {argv[0], argv[1]};
+    bool ok = true;
+    for (int i = 2; i < argc && ok; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (name == "--threads") {
+            threads = std::atoi(value.c_str());
+            ok = threads > 0;
+        } else if (name == "--area-budget") {
+            char* end = nullptr;
+            area_budget = std::strtod(value.c_str(), &end);
+            ok = !value.empty() && *end == '\0' && area_budget > 0.0;
+        } else if (name == "--format") {
+            ok = parse_output_format(value, format) && format != OutputFormat::TEXT;
+        } else if (name == "--policy") {
+            ok = parse_replacement_policy(value, policy) && policy != ReplacementPolicy::OPT;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            ok = false;
+        } else {
+            positional.push_back(argv[i]);
+        }
+    }
+    if (!ok || (positional.size() != 10 && positional.size() != 11)) {
+        std::cerr << "Usage: " << argv[0] << " --dse <BLOCKSIZES> <L1_SIZES> <L1_ASSOCS> <L2_SIZES> <L2_ASSOCS> "
+                  << "<PREF_NS> <PREF_MS> <trace_file> [output_file] [options]" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "  Lists are comma-separated; L1_ASSOCS may include \"full\", L2_SIZES 0 disables L2" << std::endl;
+        std::cerr << "  Invalid combinations are skipped; the AAT vs area Pareto front is written" << std::endl;
+        std::cerr << "  --threads=N       : Worker threads (default: all hardware threads)" << std::endl;
+        std::cerr << "  --area-budget=MM2 : Only consider designs of at most this total area" << std::endl;
+        std::cerr << "  --format=csv|json : Pareto records as CSV (default) or JSON lines" << std::endl;
+        std::cerr << "  --policy=NAME     : Replacement policy (not opt)" << std::endl;
+        return 1;
+    }
+    
+    std::vector<int> blocksizes, l1_sizes, l1_assocs, l2_sizes, l2_assocs, pref_ns, pref_ms;
+    if (!parse_sweep_list(positional[2], blocksizes, false) || !parse_sweep_list(positional[3], l1_sizes, false) ||
+        !parse_sweep_list(positional[4], l1_assocs, true) || !parse_sweep_list(positional[5], l2_sizes, false) ||
+        !parse_sweep_list(positional[6], l2_assocs, false) || !parse_sweep_list(positional[7], pref_ns, false) ||
+        !parse_sweep_list(positional[8], pref_ms, false)) {
+        std::cerr << "Error: Invalid DSE list (expected comma-separated non-negative integers)" << std::endl;
+        return 1;
+    }
+    std::string trace_file = positional[9];
+    const char* output_file = positional.size() == 11 ? positional[10] : nullptr;
+    
+    // Enumerate the valid designs; PREF_M does not matter without buffers, nor L2_ASSOC without L2
+    std::vector<DsePoint> points;
+    unsigned long invalid = 0, over_budget = 0;
+    for (int bs : blocksizes) {
+        for (int l1_size : l1_sizes) {
+            for (int l1_assoc : l1_assocs) {
+                int assoc = l1_assoc == 0 && bs > 0 ? l1_size / bs : l1_assoc;
+                for (int l2_size : l2_sizes) {
+                    for (size_t k = 0; k < l2_assocs.size() && (l2_size > 0 || k == 0); k++) {
+                        int l2_assoc = l2_size > 0 ? l2_assocs[k] : 0;
+                        for (int pref_n : pref_ns) {
+                            for (size_t m = 0; m < pref_ms.size() && (pref_n > 0 || m == 0); m++) {
+                                int pref_m = pref_n > 0 ? pref_ms[m] : 0;
+                                Cache l1_cache(bs, l1_size, assoc);
+                                Cache l2_cache(bs, l2_size, l2_assoc);
+                                if (bs <= 0 || !l1_cache.is_enabled() || !l1_cache.is_valid_configuration() ||
+                                    !l2_cache.is_valid_configuration() || (pref_n > 0 && pref_m == 0)) {
+                                    invalid++;
+                                    continue;
+                                }
+                                DsePoint point = {bs, l1_size, assoc, l2_size, l2_assoc, pref_n, pref_m,
+                                                  l1_cache.calculate_area() + l2_cache.calculate_area(),
+                                                  false, Cache::CacheStats(), Cache::CacheStats(), 0.0};
+                                if (area_budget > 0.0 && point.area > area_budget) {
+                                    over_budget++;
+                                    continue;
+                                }
+                                points.push_back(point);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    std::stable_sort(points.begin(), points.end(),
+                     [](const DsePoint& a, const DsePoint& b) { return a.area < b.area; });
+    
+    // Decode once; workers share the records and the compulsory-miss counts per block size
+    MappedFile file;
+    if (!open_trace_file(file, trace_file)) {
+        std::cerr << "Error: Cannot open trace file '" << trace_file << "'" << std::endl;
+        return 1;
+    }
+    std::vector<DecodedAccess> trace;
+    bool processed = for_each_trace_file_entry(file, [&](const TraceEntry& entry, uint64_t, std::string_view) {
+        trace.push_back({entry.address, entry.operation});
+    });
+    if (!processed) {
+        return 1;
+    }
+    std::unordered_map<int, unsigned long> unique_blocks;
+    if (is_decoded_trace(file.data(), file.size())) {
+        // The index already counts them for every power-of-two block size
+        DecodedTraceHeader header;
+        memcpy(&header, file.data(), sizeof(header));
+        for (int k = 0; k < DECODED_TRACE_BLOCK_BITS; k++) {
+            unique_blocks[1 << k] = header.unique_blocks[k];
+        }
+    }
+    for (int bs : blocksizes) {
+        if (bs <= 0 || unique_blocks.count(bs)) continue;
+        std::vector<unsigned long> blocks;
+        blocks.reserve(trace.size());
+        for (const DecodedAccess& access : trace) {
+            blocks.push_back(access.address / bs);
+        }
+        std::sort(blocks.begin(), blocks.end());
+        unique_blocks[bs] = std::unique(blocks.begin(), blocks.end()) - blocks.begin();
+    }
+    
+    std::cerr << "Exploring " << points.size() << " designs (" << invalid << " invalid, " << over_budget
+              << " over the area budget skipped) on " << threads << " threads over " << trace.size()
+              << " accesses of " << trace_file << std::endl;
+    
+    unsigned long pruned_early = 0, pruned_late = 0;
+    switch (policy) {
+    case ReplacementPolicy::PLRU: run_dse_search<PlruPolicy>(points, trace, unique_blocks, threads, pruned_early, pruned_late); break;
+    case ReplacementPolicy::FIFO: run_dse_search<FifoPolicy>(points, trace, unique_blocks, threads, pruned_early, pruned_late); break;
+    case ReplacementPolicy::RANDOM: run_dse_search<RandomPolicy>(points, trace, unique_blocks, threads, pruned_early, pruned_late); break;
+    case ReplacementPolicy::SRRIP: run_dse_search<SrripPolicy>(points, trace, unique_blocks, threads, pruned_early, pruned_late); break;
+    case ReplacementPolicy::BRRIP: run_dse_search<BrripPolicy>(points, trace, unique_blocks, threads, pruned_early, pruned_late); break;
+    default: run_dse_search<LruPolicy>(points, trace, unique_blocks, threads, pruned_early, pruned_late); break;
+    }
+    
+    // Pareto front: by increasing area, each point must beat the best AAT so far
+    std::vector<const DsePoint*> front;
+    for (const DsePoint& point : points) {
+        if (point.evaluated && (front.empty() || point.aat < front.back()->aat)) {
+            if (!front.empty() && front.back()->area == point.area) {
+                front.pop_back();
+            }
+            front.push_back(&point);
+        }
+    }
+    std::cerr << "Simulated " << points.size() - pruned_early - pruned_late << ", pruned " << pruned_early
+              << " before and " << pruned_late << " during simulation; Pareto front of " << front.size()
+              << " designs" << std::endl;
+    if (area_budget > 0.0 && !front.empty()) {
+        const DsePoint& best = *front.back();
+        std::cerr << "Best AAT within " << area_budget << " mm2: " << std::fixed << std::setprecision(4) << best.aat
+                  << " cycles (" << best.blocksize << " " << best.l1_size << " " << best.l1_assoc << " "
+                  << best.l2_size << " " << best.l2_assoc << " " << best.pref_n << " " << best.pref_m << ")"
+                  << std::defaultfloat << std::endl;
+    }
+    
+    std::ofstream out_file;
+    if (output_file != nullptr) {
+        out_file.open(output_file);
+        if (!out_file.is_open()) {
+            std::cerr << "Error: Cannot open output file '" << output_file << "'" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = output_file != nullptr ? out_file : std::cout;
+    for (size_t i = 0; i < front.size(); i++) {
+        const DsePoint& point = *front[i];
+        StatsRecord record;
+        record.add("blocksize", point.blocksize);
+        record.add("l1_size", point.l1_size);
+        record.add("l1_assoc", point.l1_assoc);
+        record.add("l2_size", point.l2_size);
+        record.add("l2_assoc", point.l2_assoc);
+        record.add("pref_n", point.pref_n);
+        record.add("pref_m", point.pref_m);
+        record.add("aat", point.aat);
+        record.add("total_area_mm2", point.area);
+        record.add_cache_stats("l1_", point.l1_stats);
+        record.add_cache_stats("l2_", point.l2_stats);
+        record.write(out, format, i == 0);
+    }
+    if (output_file != nullptr) {
+        std::cerr << "Results saved to: " << output_file << std::endl;
+    }
+    return 0;
+}
+
+// Synthetic access streams for --bench, rendered as text traces so that parsing is
+// measured too. Every generator is seeded, so runs are reproducible.
+enum BenchPattern { BENCH_SEQUENTIAL, BENCH_STRIDED, BENCH_RANDOM, BENCH_ZIPF, BENCH_PATTERNS };
+
+const char* const BENCH_PATTERN_NAMES[BENCH_PATTERNS] = {"sequential", "strided", "random", "zipf"};
+
+std::string generate_bench_trace(BenchPattern pattern, unsigned long accesses, unsigned long stride,
+                                 uint64_t seed) {
+    const unsigned long FOOTPRINT = 16ul << 20;       // Bytes touched by strided/random streams
+    const unsigned long ZIPF_BLOCKS = 1ul << 16;      // 64-byte blocks ranked by popularity
+    const double ZIPF_EXPONENT = 0.99;
+    const double WRITE_FRACTION = 0.3;
+    
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    
+    std::vector<double> zipf_cdf;
+    if (pattern == BENCH_ZIPF) {
+        zipf_cdf.resize(ZIPF_BLOCKS);
+        double sum = 0.0;
+        for (unsigned long rank = 0; rank < ZIPF_BLOCKS; rank++) {
+            sum += 1.0 / std::pow(static_cast<double>(rank + 1), ZIPF_EXPONENT);
+            zipf_cdf[rank] = sum;
+        }
+        for (double& value : zipf_cdf) {
+            value /= sum;
+        }
+    }
+    
+    std::string trace;
+    trace.reserve(accesses * 11);
+    char line[16];
+    for (unsigned long i = 0; i < accesses; i++) {
+        unsigned long address = 0;
+        switch (pattern) {
+            case BENCH_SEQUENTIAL:
+                address = (i * 4) & 0xFFFFFFFFul;
+                break;
+            case BENCH_STRIDED:
+                address = (i * stride) % FOOTPRINT;
+                break;
+            case BENCH_RANDOM:
+                address = (rng() % FOOTPRINT) & ~3ul;
+                break;
+            default: {
+                // Scatter ranks over the footprint (odd multiplier: a bijection mod 2^16)
+                unsigned long rank = std::lower_bound(zipf_cdf.begin(), zipf_cdf.end(), unit(rng)) - zipf_cdf.begin();
+                rank = std::min(rank, ZIPF_BLOCKS - 1);
+                unsigned long block = (rank * 40503ul) & (ZIPF_BLOCKS - 1);
+                address = block * 64 + (rng() & 60);
+                break;
+            }
+        }
+        char op = unit(rng) < WRITE_FRACTION ? 'w' : 'r';
+        int n = std::snprintf(line, sizeof(line), "%c %08lx\n", op, address);
+        trace.append(line, n);
+    }
+    return trace;
+}
+
+// Benchmark mode: simulation throughput on synthetic streams (or a trace file), with a
+// per-phase breakdown when built with CACHE_SIM_PROFILE
+int run_bench(int argc, char* argv[]) {
+    unsigned long accesses = 4000000;
+    unsigned long stride = 256;
+    uint64_t seed = 1;
+    std::vector<BenchPattern> patterns;
+    std::vector<std::string> positional;
+    bool ok = true;
+    for (int i = 2; i < argc && ok; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (name == "--accesses" || name == "--stride" || name == "--seed") {
+            char* end = nullptr;
+            unsigned long number = std::strtoul(value.c_str(), &end, 10);
+            ok = !value.empty() && *end == '\0' && (number > 0 || name == "--seed");
+            if (name == "--accesses") {
+                accesses = number;
+            } else if (name == "--stride") {
+                stride = number;
+            } else {
+                seed = number;
+            }
+        } else if (name == "--pattern") {
+            std::istringstream list(value);
+            std::string item;
+            while (ok && std::getline(list, item, ',')) {
+                const char* const* found = std::find(BENCH_PATTERN_NAMES, BENCH_PATTERN_NAMES + BENCH_PATTERNS, item);
+                ok = found != BENCH_PATTERN_NAMES + BENCH_PATTERNS;
+                patterns.push_back(static_cast<BenchPattern>(found - BENCH_PATTERN_NAMES));
+            }
+            ok = ok && !patterns.empty();
+        } else if (arg.compare(0, 2, "--") == 0) {
+            ok = false;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (!ok || (positional.size() != 0 && positional.size() != 1 && positional.size() != 5 && positional.size() != 6)) {
+        std::cerr << "Usage: " << argv[0] << " --bench [BLOCKSIZE L1_SIZE L1_ASSOC L2_SIZE L2_ASSOC] [trace_file] [options]" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "  Default hierarchy: 32 8192 4 262144 8; without a trace file the synthetic" << std::endl;
+        std::cerr << "  patterns are generated in memory" << std::endl;
+        std::cerr << "  --pattern=LIST : Any of sequential,strided,random,zipf (default: all)" << std::endl;
+        std::cerr << "  --accesses=N   : Accesses per synthetic pattern (default: 4000000)" << std::endl;
+        std::cerr << "  --stride=N     : Byte stride of the strided pattern (default: 256)" << std::endl;
+        std::cerr << "  --seed=N       : Generator seed (default: 1)" << std::endl;
+        return 1;
+    }
     
-    // L1 writebacks
-    std::cout << "f. number of writebacks from L1: " << l1_stats.writebacks << std::endl;
+    int geometry[5] = {32, 8192, 4, 262144, 8};
+    if (positional.size() >= 5) {
+        for (int i = 0; i < 5; i++) {
+            geometry[i] = std::atoi(positional[i].c_str());
+        }
+    }
+    std::string trace_file = positional.size() % 5 == 1 ? positional.back() : "";
     
-    // L1 prefetches (always 0 for ECE 463)
-    std::cout << "g. number of L1 prefetches:   0" << std::endl;
+    Cache l2_cache(geometry[0], geometry[3], geometry[4]);
+    Cache l1_cache(geometry[0], geometry[1], geometry[2]);
+    if (!l1_cache.is_enabled() || !l1_cache.is_valid_configuration() || !l2_cache.is_valid_configuration()) {
+        std::cerr << "Error: Invalid cache configuration - "
+                  << (!l1_cache.is_enabled() ? "L1 cache size must be positive"
+                      : !l1_cache.is_valid_configuration() ? l1_cache.get_config_error()
+                      : l2_cache.get_config_error()) << std::endl;
+        return 1;
+    }
+    connect_hierarchy(l1_cache, l2_cache);
     
+    std::cout << "===== Benchmark =====" << std::endl;
+    std::cout << "Hierarchy: BLOCKSIZE " << geometry[0] << ", L1 " << geometry[1] << " B " << geometry[2] << "-way";
     if (l2_cache.is_enabled()) {
-        const auto& l2_stats = l2_cache.get_stats();
-        
-        // L2 statistics
-        std::cout << "h. number of L2 reads (demand): " << l2_stats.reads << std::endl;
-        std::cout << "i. number of L2 read misses (demand): " << l2_stats.read_misses << std::endl;
-        
-        // L2 prefetch reads (always 0 for ECE 463)
-        std::cout << "j. number of L2 reads (prefetch): 0" << std::endl;
-        std::cout << "k. number of L2 read misses (prefetch): 0" << std::endl;
-        
-        std::cout << "l. number of L2 writes:       " << l2_stats.writes << std::endl;
-        std::cout << "m. number of L2 write misses: " << l2_stats.write_misses << std::endl;
-        
-        // L2 miss rate (from CPU perspective)
-        double l2_miss_rate = l2_stats.reads > 0 ? (double)l2_stats.read_misses / l2_stats.reads : 0.0;
-        std::cout << "n. L2 miss rate:              " << std::fixed << std::setprecision(6) << l2_miss_rate << std::endl;
-        
-        std::cout << "o. number of writebacks from L2: " << l2_stats.writebacks << std::endl;
-        
-        // L2 prefetches (always 0 for ECE 463)
-        std::cout << "p. number of L2 prefetches:   0" << std::endl;
-        
-        // Total memory traffic (with L2)
-        unsigned long memory_traffic = l2_stats.read_misses + l2_stats.write_misses + l2_stats.writebacks;
-        std::cout << "q. total memory traffic:      " << memory_traffic << std::endl;
-        
-    } else {
-        // No L2 cache - print 0s for L2 stats
-        std::cout << "h. number of L2 reads (demand): 0" << std::endl;
-        std::cout << "i. number of L2 read misses (demand): 0" << std::endl;
-        std::cout << "j. number of L2 reads (prefetch): 0" << std::endl;
-        std::cout << "k. number of L2 read misses (prefetch): 0" << std::endl;
-        std::cout << "l. number of L2 writes:       0" << std::endl;
-        std::cout << "m. number of L2 write misses: 0" << std::endl;
-        std::cout << "n. L2 miss rate:              0.000000" << std::endl;
-        std::cout << "o. number of writebacks from L2: 0" << std::endl;
-        std::cout << "p. number of L2 prefetches:   0" << std::endl;
-        
-        // Total memory traffic (without L2)
-        unsigned long memory_traffic = l1_stats.read_misses + l1_stats.write_misses + l1_stats.writebacks;
-        std::cout << "q. total memory traffic:      " << memory_traffic << std::endl;
+        std::cout << ", L2 " << geometry[3] << " B " << geometry[4] << "-way";
     }
+    std::cout << ", " << Cache::policy_type::name() << std::endl;
+#ifdef CACHE_SIM_PROFILE
+    std::cout << "Phase timers: compiled in (ns/access per phase; other = trace scanning and loop)" << std::endl;
+#else
+    std::cout << "Phase timers: compiled out (build with make bench or make PROFILE=1 for the breakdown)" << std::endl;
+#endif
+    std::cout << std::endl;
     
+    std::cout << std::left << std::setw(12) << "pattern" << std::right << std::setw(11) << "accesses"
+              << std::setw(10) << "seconds" << std::setw(11) << "Macc/s" << std::setw(11) << "ns/access"
+              << std::setw(10) << "L1 miss";
+#ifdef CACHE_SIM_PROFILE
+    std::cout << std::setw(9) << "parse" << std::setw(10) << "simulate" << std::setw(9) << "analyze"
+              << std::setw(8) << "other";
+#endif
     std::cout << std::endl;
     
-    // Additional performance metrics
-    std::cout << "===== Performance Metrics =====" << std::endl;
-    std::cout << "L1 Average Access Time:       " << std::fixed << std::setprecision(2) 
-              << l1_stats.get_aat() << " cycles" << std::endl;
-    std::cout << "L1 Cache Area:                " << std::fixed << std::setprecision(4) 
-              << l1_stats.area_mm2 << " mm²" << std::endl;
-    std::cout << "L1 Performance/Area:          " << std::scientific << std::setprecision(2) 
-              << l1_stats.get_performance_per_area() << " (1/cycles)/mm²" << std::endl;
+    // Simulate one access stream from a cold hierarchy; walk(callback) feeds it
+    auto run_stream = [&](const std::string& label, auto&& walk) {
+        l1_cache.reset();
+        l2_cache.reset();
+        PerformanceAnalyzer analyzer;
+        analyzer.enable_streaming(l1_cache);
+        unsigned long total_accesses = 0;
+#ifdef CACHE_SIM_PROFILE
+        std::fill(profile_phase_ticks, profile_phase_ticks + PROFILE_PHASES, 0);
+        uint64_t start_ticks = profile_ticks();
+#endif
+        auto start = std::chrono::steady_clock::now();
+        TraceBatch pending;
+        auto simulate_pending = [&]() {
+            PROFILE_SCOPE(PROFILE_SIMULATE);
+            l1_cache.access_batch(pending.entries.data(), pending.entries.size());
+            pending.entries.clear();
+        };
+        bool processed = walk([&](const TraceEntry& entry, uint64_t, std::string_view) {
+            pending.entries.push_back(entry);
+            if (pending.entries.size() == TraceBatch::CAPACITY) {
+                simulate_pending();
+            }
+            {
+                PROFILE_SCOPE(PROFILE_ANALYZE);
+                analyzer.record_access(entry.address, entry.operation, total_accesses);
+            }
+            total_accesses++;
+        });
+        simulate_pending();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!processed) {
+            return false;
+        }
+        
+        double per_access = total_accesses > 0 ? seconds * 1e9 / total_accesses : 0.0;
+        std::cout << std::left << std::setw(12) << label << std::right << std::setw(11) << total_accesses
+                  << std::fixed << std::setprecision(3) << std::setw(10) << seconds
+                  << std::setprecision(2) << std::setw(11) << (seconds > 0 ? total_accesses / seconds / 1e6 : 0.0)
+                  << std::setw(11) << per_access
+                  << std::setprecision(4) << std::setw(10) << l1_cache.get_stats().get_overall_miss_rate();
+#ifdef CACHE_SIM_PROFILE
+        // Ticks -> ns, calibrated against the wall clock over the same interval
+        uint64_t elapsed_ticks = profile_ticks() - start_ticks;
+        double ns_per_tick = elapsed_ticks > 0 ? seconds * 1e9 / elapsed_ticks : 0.0;
+        double phase_ns[PROFILE_PHASES];
+        double timed = 0.0;
+        for (int phase = 0; phase < PROFILE_PHASES; phase++) {
+            phase_ns[phase] = total_accesses > 0 ? profile_phase_ticks[phase] * ns_per_tick / total_accesses : 0.0;
+            timed += phase_ns[phase];
+        }
+        std::cout << std::setprecision(2) << std::setw(9) << phase_ns[PROFILE_PARSE]
+                  << std::setw(10) << phase_ns[PROFILE_SIMULATE] << std::setw(9) << phase_ns[PROFILE_ANALYZE]
+                  << std::setw(8) << std::max(per_access - timed, 0.0);
+#endif
+        std::cout << std::endl;
+        return true;
+    };
     
-    if (l2_cache.is_enabled()) {
-        const auto& l2_stats = l2_cache.get_stats();
-        std::cout << "L2 Average Access Time:       " << std::fixed << std::setprecision(2) 
-                  << l2_stats.get_aat() << " cycles" << std::endl;
-        std::cout << "L2 Cache Area:                " << std::fixed << std::setprecision(4) 
-                  << l2_stats.area_mm2 << " mm²" << std::endl;
-        std::cout << "Total Cache Area:             " << std::fixed << std::setprecision(4) 
-                  << (l1_stats.area_mm2 + l2_stats.area_mm2) << " mm²" << std::endl;
+    if (!trace_file.empty()) {
+        MappedFile file;
+        if (!open_trace_file(file, trace_file)) {
+            std::cerr << "Error: Cannot open trace file '" << trace_file << "'" << std::endl;
+            return 1;
+        }
+        bool processed = run_stream(trace_file, [&](auto&& callback) {
+            return for_each_trace_file_entry(file, callback);
+        });
+        return processed ? 0 : 1;
     }
     
-    std::cout << std::endl;
+    if (patterns.empty()) {
+        for (int pattern = 0; pattern < BENCH_PATTERNS; pattern++) {
+            patterns.push_back(static_cast<BenchPattern>(pattern));
+        }
+    }
+    for (BenchPattern pattern : patterns) {
+        std::string trace = generate_bench_trace(pattern, accesses, stride, seed);
+        run_stream(BENCH_PATTERN_NAMES[pattern], [&](auto&& callback) {
+            for_each_trace_entry(trace.data(), trace.size(), callback);
+            return true;
+        });
+    }
+    return 0;
 }
 
 // Helper function to create a sample trace file for testing
 void create_sample_trace(const std::string& filename) {
     std::ofstream file(filename);
     if (file.is_open()) {
-        file << "# Sample trace file demonstrating 32-bit address format\n";
+        file << "# Sample trace file demonstrating the hexadecimal address format\n";
         file << "# Leading zeros may be omitted\n";
         file << "r ffe04540\n";      // Full 8-digit address
         file << "r ffe04544\n";      // Full 8-digit address  
@@ -1057,51 +7554,23 @@ void create_sample_trace(const std::string& filename) {
     }
 }
 
-int main(int argc, char* argv[]) {
-    // Check if exactly 8 command-line arguments are provided
-    if (argc != 9) {  // Program name + 8 arguments = 9 total
-        std::cerr << "Usage: " << argv[0] << " <BLOCKSIZE> <L1_SIZE> <L1_ASSOC> <L2_SIZE> <L2_ASSOC> <PREF_N> <PREF_M> <trace_file>" << std::endl;
-        std::cerr << std::endl;
-        std::cerr << "Arguments:" << std::endl;
-        std::cerr << "  BLOCKSIZE : Block size in bytes (positive integer)" << std::endl;
-        std::cerr << "  L1_SIZE   : L1 cache size in bytes (positive integer)" << std::endl;
-        std::cerr << "  L1_ASSOC  : L1 set-associativity (positive integer)" << std::endl;
-        std::cerr << "  L2_SIZE   : L2 cache size in bytes (positive integer, 0 = no L2)" << std::endl;
-        std::cerr << "  L2_ASSOC  : L2 set-associativity (positive integer)" << std::endl;
-        std::cerr << "  PREF_N    : Number of Stream Buffers (positive integer, 0 = disabled)" << std::endl;
-        std::cerr << "  PREF_M    : Number of memory blocks per Stream Buffer (positive integer)" << std::endl;
-        std::cerr << "  trace_file: Full name of trace file" << std::endl;
-        return 1;
-    }
-
-    // Parse command-line arguments
-    int blocksize = std::atoi(argv[1]);
-    int l1_size = std::atoi(argv[2]);
-    int l1_assoc = std::atoi(argv[3]);
-    int l2_size = std::atoi(argv[4]);
-    int l2_assoc = std::atoi(argv[5]);
-    int pref_n = std::atoi(argv[6]);
-    int pref_m = std::atoi(argv[7]);
-    std::string trace_file = argv[8];
-
+// Build, run and report one hierarchy whose caches use the given replacement policy
+template <class Policy>
+int simulate_configuration(int blocksize, int l1_size, int l1_assoc, int l2_size, int l2_assoc,
+                           int pref_n, int pref_m, const std::string& trace_file,
+                           const SimulatorOptions& options) {
     // Create cache structures with timing parameters
-    Cache l2_cache(blocksize, l2_size, l2_assoc);  // L2 cache (next level = memory)
-    Cache l1_cache(blocksize, l1_size, l1_assoc);  // L1 cache
+    CacheT<Policy> l2_cache(blocksize, l2_size, l2_assoc);  // L2 cache (next level = memory)
+    CacheT<Policy> l1_cache(blocksize, l1_size, l1_assoc);  // L1 cache
     
     // Set up memory hierarchy: L1 -> L2 -> Memory
-    if (l2_cache.is_enabled()) {
-        l1_cache.set_next_level(&l2_cache);
-        // L2's next level is memory (nullptr by default)
-        l2_cache.set_timing_parameters(10, 100);  // L2: 10 cycle hit, 100 cycle miss penalty
-    } else {
-        // No L2 cache, L1 goes directly to memory (nullptr by default)
-    }
-    
-    // Set L1 timing parameters
-    l1_cache.set_timing_parameters(1, l2_cache.is_enabled() ? 10 : 100);  // L1: 1 cycle hit, miss penalty depends on L2
+    connect_hierarchy(l1_cache, l2_cache);
     
     // Create performance analyzer
     PerformanceAnalyzer analyzer;
+    if (options.streaming_analysis) {
+        analyzer.enable_streaming(l1_cache);
+    }
 
     // Validate arguments using the cache validation methods
     if (!l1_cache.is_valid_configuration()) {
@@ -1126,6 +7595,12 @@ int main(int argc, char* argv[]) {
         std::cerr << "Error: PREF_M must be positive when PREF_N > 0" << std::endl;
         return 1;
     }
+    
+    // Quiet runs print only the final statistics and record nothing for the report
+    StdoutMute mute(options.quiet);
+    if (options.quiet) {
+        analyzer.disable();
+    }
 
     // Print configuration for verification
     std::cout << "===== Simulator configuration =====" << std::endl;
@@ -1136,29 +7611,476 @@ int main(int argc, char* argv[]) {
     std::cout << "L2_ASSOC:              " << l2_cache.get_associativity() << std::endl;
     std::cout << "PREF_N:                " << pref_n << std::endl;
     std::cout << "PREF_M:                " << pref_m << std::endl;
+    std::cout << "REPLACEMENT_POLICY:    " << Policy::name() << std::endl;
+    if (options.cores > 0) {
+        std::cout << "CORES:                 " << options.cores
+                  << (options.split_l1 ? " (private L1I + L1D each)" : " (private L1 each)") << std::endl;
+    }
     std::cout << "trace_file:            " << trace_file << std::endl;
     std::cout << std::endl;
 
+    // OPT's future knowledge only covers the L1 access stream
+    if (Policy::NEEDS_FUTURE && (l2_cache.is_enabled() || options.threads > 1 || options.pipeline_stages > 1 ||
+                                 options.cores > 0 || options.set_sampling > 0 || options.sample_unit > 0 ||
+                                 options.checkpoint_at > 0 || options.restore || options.interval > 0 ||
+                                 options.timing)) {
+        std::cerr << "Error: --policy=opt requires a single-core L1-only hierarchy without --threads, --pipeline,"
+                  << " sampling, checkpoints, intervals or --timing" << std::endl;
+        return 1;
+    }
+    
+    if (options.classify_misses) {
+        l1_cache.classify_misses();
+        l2_cache.classify_misses();
+    }
+    
+    // Stream buffers attach to the last-level cache
+    CacheT<Policy>& last_level = l2_cache.is_enabled() ? l2_cache : l1_cache;
+    last_level.set_prefetcher(pref_n, pref_m);
+    if (options.threads > 1 && last_level.has_prefetcher()) {
+        std::cerr << "Error: --threads cannot be combined with stream-buffer prefetching" << std::endl;
+        return 1;
+    }
+    
+    // Multi-core: private L1s per core in front of the shared L2, which holds the prefetcher
+    std::unique_ptr<MultiCoreSystem<CacheT<Policy>>> multicore;
+    if (options.cores > 0) {
+        if (!l2_cache.is_enabled() && last_level.has_prefetcher()) {
+            std::cerr << "Error: Multi-core prefetching needs a shared L2 for the stream buffers" << std::endl;
+            return 1;
+        }
+        multicore = std::make_unique<MultiCoreSystem<CacheT<Policy>>>(options.cores, options.split_l1, l1_cache);
+    }
+    
+    // Set groups are independent only when no prefetcher couples them
+    std::unique_ptr<SamplingEstimate> sampling;
+    if (options.set_sampling > 0) {
+        unsigned long groups = l1_cache.get_num_sets();
+        if (l2_cache.is_enabled()) {
+            groups = std::min(groups, static_cast<unsigned long>(l2_cache.get_num_sets()));
+        }
+        if (last_level.has_prefetcher()) {
+            std::cerr << "Error: --set-sampling cannot be combined with stream-buffer prefetching" << std::endl;
+            return 1;
+        }
+        if (options.set_sampling > groups) {
+            std::cerr << "Error: --set-sampling=" << options.set_sampling << " exceeds the " << groups
+                      << " independent set groups" << std::endl;
+            return 1;
+        }
+    }
+    if (options.set_sampling > 0 || options.sample_unit > 0) {
+        sampling = std::make_unique<SamplingEstimate>();
+    }
+    
+    std::unique_ptr<TimingModel<CacheT<Policy>>> timing;
+    if (options.timing) {
+        std::vector<std::pair<std::string, CacheT<Policy>*>> levels = {{"l1", &l1_cache}};
+        if (l2_cache.is_enabled()) {
+            levels.push_back({"l2", &l2_cache});
+        }
+        timing = std::make_unique<TimingModel<CacheT<Policy>>>(levels, options.mshrs, options.bus_cycles);
+    }
+    
     // Process the trace file
     std::cout << "Starting cache simulation..." << std::endl;
-    if (!process_trace_file(trace_file, l1_cache, l2_cache, analyzer)) {
+    if (!process_trace_file(trace_file, l1_cache, l2_cache, analyzer, options, multicore.get(), sampling.get(),
+                            timing.get())) {
         std::cerr << "Error: Failed to process trace file" << std::endl;
         return 1;
     }
     
     std::cout << std::endl;
+    mute.release();
     
-    // Print final cache contents
-    l1_cache.print_cache_contents("L1");
-    if (l2_cache.is_enabled()) {
-        l2_cache.print_cache_contents("L2");
+    if (options.format != OutputFormat::TEXT) {
+        StatsRecord record = make_stats_record(l1_cache, l2_cache, pref_n, pref_m, trace_file, options, sampling.get());
+        if (timing) {
+            timing->add_stats(record);
+        }
+        record.write(std::cout, options.format);
+        return 0;
+    }
+    
+    // Print final cache contents (per core in multi-core mode; L1 totals cover all cores)
+    if (!options.quiet) {
+        if (multicore) {
+            multicore->print_cache_contents();
+        } else {
+            l1_cache.print_cache_contents("L1");
+        }
+        if (l2_cache.is_enabled()) {
+            l2_cache.print_cache_contents("L2");
+        }
+        last_level.print_stream_buffers();
     }
     
     // Print simulation results in required format
-    print_simulation_results(l1_cache, l2_cache);
+    print_simulation_results(l1_cache, l2_cache, sampling.get());
+    if (multicore) {
+        multicore->print_core_stats();
+    }
+    if (timing) {
+        timing->print();
+    }
     
     // Generate comprehensive performance analysis report
-    analyzer.generate_performance_report(l1_cache, l2_cache, trace_file);
+    if (!options.quiet) {
+        analyzer.generate_performance_report(l1_cache, l2_cache, trace_file);
+    }
 
     return 0;
+}
+
+// Hierarchy-file mode: simulate the N-level hierarchy described in a config file
+template <class Policy>
+int simulate_hierarchy(const std::string& config_file, const std::string& trace_file,
+                       const SimulatorOptions& options) {
+    HierarchyConfig config;
+    std::string error;
+    if (!load_hierarchy_config(config_file, config, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+    // OPT runs through the next-use pass of process_trace_opt, which drives one cache
+    if (Policy::NEEDS_FUTURE && (config.levels.size() > 1 || options.interval > 0 || options.timing)) {
+        std::cerr << "Error: --policy=opt requires an L1-only hierarchy without intervals or --timing" << std::endl;
+        return 1;
+    }
+    
+    CacheHierarchy<CacheT<Policy>> hierarchy(config);
+    error = hierarchy.get_config_error();
+    if (!error.empty()) {
+        std::cerr << "Error: Invalid cache configuration - " << error << std::endl;
+        return 1;
+    }
+    
+    if (options.classify_misses) {
+        for (size_t k = 0; k < hierarchy.depth(); k++) {
+            hierarchy.level(k).classify_misses();
+        }
+    }
+    
+    std::unique_ptr<TimingModel<CacheT<Policy>>> timing;
+    if (options.timing) {
+        std::vector<std::pair<std::string, CacheT<Policy>*>> levels;
+        for (size_t k = 0; k < hierarchy.depth(); k++) {
+            levels.push_back({"l" + std::to_string(k + 1), &hierarchy.level(k)});
+        }
+        timing = std::make_unique<TimingModel<CacheT<Policy>>>(levels, options.mshrs, options.bus_cycles);
+    }
+    
+    StdoutMute mute(options.quiet);
+    std::cout << "===== Simulator configuration =====" << std::endl;
+    std::cout << "BLOCKSIZE:             " << config.block_size << std::endl;
+    for (size_t k = 0; k < hierarchy.depth(); k++) {
+        const CacheLevelConfig& level = config.levels[k];
+        std::cout << std::left << std::setw(23) << (hierarchy.level_name(k) + ":") << std::right
+                  << level.size << " B, " << level.assoc << "-way, " << level.hit_latency << " cycles, "
+                  << inclusion_policy_name(level.inclusion) << std::endl;
+    }
+    std::cout << "MEMORY_LATENCY:        " << config.memory_latency << std::endl;
+    std::cout << "PREF_N:                " << config.pref_n << std::endl;
+    std::cout << "PREF_M:                " << config.pref_m << std::endl;
+    std::cout << "REPLACEMENT_POLICY:    " << Policy::name() << std::endl;
+    std::cout << "trace_file:            " << trace_file << std::endl;
+    std::cout << std::endl;
+    
+    MappedFile file;
+    if (!open_trace_file(file, trace_file)) {
+        std::cerr << "Error: Cannot open trace file '" << trace_file << "'" << std::endl;
+        return 1;
+    }
+    
+    IntervalRecorder<CacheT<Policy>> intervals;
+    if (options.interval > 0) {
+        typename IntervalRecorder<CacheT<Policy>>::Levels levels;
+        for (size_t k = 0; k < hierarchy.depth(); k++) {
+            levels.push_back({"l" + std::to_string(k + 1), &hierarchy.level(k)});
+        }
+        if (!intervals.open(options.interval_file.empty() ? trace_file + ".intervals.csv" : options.interval_file,
+                            options.interval, levels, 0)) {
+            return 1;
+        }
+    }
+    
+    std::cout << "Processing trace file: " << trace_file << std::endl;
+    unsigned long total_accesses = 0;
+    bool processed;
+    if constexpr (Policy::NEEDS_FUTURE) {
+        PerformanceAnalyzer analyzer;
+        analyzer.disable();
+        processed = process_trace_opt(file, hierarchy.level(0), analyzer, options, total_accesses);
+    } else {
+        processed = for_each_trace_file_entry(file, [&](const TraceEntry& entry, uint64_t line_number, std::string_view line) {
+            if (options.verbose || total_accesses < 5) {
+                print_trace_entry(entry, line_number, line);
+            }
+            if (timing) {
+                timing->access(entry.address, entry.operation == 'w');
+            } else {
+                hierarchy.access(entry.address, entry.operation == 'w');
+            }
+            total_accesses++;
+            if (intervals.due(total_accesses)) {
+                intervals.record(total_accesses);
+            }
+        });
+    }
+    if (!processed || !intervals.finish(total_accesses)) {
+        return 1;
+    }
+    std::cout << "Trace processing complete. Total accesses: " << total_accesses << std::endl;
+    std::cout << std::endl;
+    mute.release();
+    
+    const CacheT<Policy>& last_level = hierarchy.level(hierarchy.depth() - 1);
+    if (options.format != OutputFormat::TEXT) {
+        StatsRecord record;
+        record.add("blocksize", config.block_size);
+        record.add("levels", static_cast<int>(hierarchy.depth()));
+        record.add("memory_latency", config.memory_latency);
+        record.add("pref_n", config.pref_n);
+        record.add("pref_m", config.pref_m);
+        record.add("policy", std::string(Policy::name()));
+        record.add("trace", trace_file);
+        record.add("accesses", total_accesses);
+        for (size_t k = 0; k < hierarchy.depth(); k++) {
+            std::string prefix = "l" + std::to_string(k + 1) + "_";
+            record.add(prefix + "size", config.levels[k].size);
+            record.add(prefix + "assoc", config.levels[k].assoc);
+            record.add(prefix + "inclusion", std::string(inclusion_policy_name(config.levels[k].inclusion)));
+            record.add_cache_stats(prefix, hierarchy.level(k).get_stats());
+        }
+        record.add("aat", hierarchy.get_aat());
+        record.add("total_area_mm2", hierarchy.get_total_area());
+        if (timing) {
+            timing->add_stats(record);
+        }
+        record.write(std::cout, options.format);
+        return 0;
+    }
+    
+    if (!options.quiet) {
+        for (size_t k = 0; k < hierarchy.depth(); k++) {
+            hierarchy.level(k).print_cache_contents(hierarchy.level_name(k));
+        }
+        last_level.print_stream_buffers();
+    }
+    
+    std::cout << "===== Simulation results (raw) =====" << std::endl;
+    for (size_t k = 0; k < hierarchy.depth(); k++) {
+        const auto& stats = hierarchy.level(k).get_stats();
+        std::string name = hierarchy.level_name(k);
+        auto row = [&](const std::string& label) -> std::ostream& {
+            return std::cout << std::setfill(' ') << std::left << std::setw(30) << (name + " " + label + ":")
+                             << std::right;
+        };
+        row("reads") << stats.reads << std::endl;
+        row("read misses") << stats.read_misses << std::endl;
+        row("writes") << stats.writes << std::endl;
+        row("write misses") << stats.write_misses << std::endl;
+        // Like lines e and n: lower levels are rated on the demand reads they serve
+        double miss_rate = k == 0 ? stats.get_overall_miss_rate() : stats.get_read_miss_rate();
+        row("miss rate") << std::fixed << std::setprecision(6) << miss_rate << std::endl;
+        row("writebacks") << stats.writebacks << std::endl;
+        if (stats.back_invalidations > 0) {
+            row("back-invalidations") << stats.back_invalidations << std::endl;
+        }
+        if (k > 0 && config.levels[k].inclusion == InclusionPolicy::EXCLUSIVE) {
+            row("victim fills") << stats.victim_fills << std::endl;
+        }
+    }
+    std::cout << std::left << std::setw(30) << (hierarchy.level_name(hierarchy.depth() - 1) + " prefetches:")
+              << std::right << last_level.get_stats().prefetches << std::endl;
+    std::cout << std::left << std::setw(30) << "total memory traffic:" << std::right
+              << last_level.get_stats().memory_traffic << std::endl;
+    std::cout << std::endl;
+    
+    if (options.classify_misses) {
+        std::cout << "===== Miss Classification (3C) =====" << std::endl;
+        for (size_t k = 0; k < hierarchy.depth(); k++) {
+            print_miss_classification(hierarchy.level_name(k), hierarchy.level(k).get_stats());
+        }
+        std::cout << std::endl;
+    }
+    
+    std::cout << "===== Performance Analysis =====" << std::endl;
+    std::cout << "Hierarchical AAT (L1-L" << hierarchy.depth() << "+Mem): " << std::fixed << std::setprecision(2)
+              << hierarchy.get_aat() << " cycles" << std::endl;
+    std::cout << "Total Cache Area:             " << std::fixed << std::setprecision(4)
+              << hierarchy.get_total_area() << " mm²" << std::endl;
+    if (timing) {
+        std::cout << std::endl;
+        timing->print();
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    // --trace-cache and --address-bits apply to every mode
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--trace-cache") == 0) {
+            trace_cache_enabled = true;
+            continue;
+        }
+        if (std::strncmp(argv[i], "--address-bits=", 15) == 0) {
+            char* end = nullptr;
+            long bits = std::strtol(argv[i] + 15, &end, 10);
+            if (end == argv[i] + 15 || *end != '\0' || bits < 1 || bits > 64) {
+                std::cerr << "Error: --address-bits expects an integer from 1 to 64" << std::endl;
+                return 1;
+            }
+            area_address_bits = static_cast<int>(bits);
+            continue;
+        }
+        argv[kept++] = argv[i];
+    }
+    argc = kept;
+    
+    // Sweep mode: many geometries simulated from one trace read
+    if (argc >= 2 && std::string(argv[1]) == "--sweep") {
+        return run_sweep(argc, argv);
+    }
+    
+    // Convert mode: text trace -> compact binary trace
+    if (argc >= 2 && (std::string(argv[1]) == "convert" || std::string(argv[1]) == "--convert")) {
+        return run_convert(argc, argv);
+    }
+    
+    // Index mode: decoded sidecar of a trace for --trace-cache, plus its summary
+    if (argc >= 2 && std::string(argv[1]) == "index") {
+        return run_index(argc, argv);
+    }
+    
+    // Stack-distance mode: every LRU cache size from one pass
+    if (argc >= 2 && std::string(argv[1]) == "--stack-distance") {
+        return run_stack_distance(argc, argv);
+    }
+    
+    // Design-space exploration: Pareto front of AAT vs area over parameter ranges
+    if (argc >= 2 && std::string(argv[1]) == "--dse") {
+        return run_dse(argc, argv);
+    }
+    
+    // Benchmark mode: throughput on synthetic streams, no trace file needed
+    if (argc >= 2 && std::string(argv[1]) == "--bench") {
+        return run_bench(argc, argv);
+    }
+    
+    // Options may appear anywhere; exactly 8 positional arguments must remain
+    SimulatorOptions options;
+    std::vector<std::string> args;
+    if (!parse_simulator_options(argc, argv, options, args)) {
+        return 1;
+    }
+    
+    // Hierarchy-file mode: the geometry comes from the file, only the trace remains
+    if (!options.hierarchy_file.empty() && args.size() == 1) {
+        switch (options.policy) {
+        case ReplacementPolicy::PLRU: return simulate_hierarchy<PlruPolicy>(options.hierarchy_file, args[0], options);
+        case ReplacementPolicy::FIFO: return simulate_hierarchy<FifoPolicy>(options.hierarchy_file, args[0], options);
+        case ReplacementPolicy::RANDOM: return simulate_hierarchy<RandomPolicy>(options.hierarchy_file, args[0], options);
+        case ReplacementPolicy::SRRIP: return simulate_hierarchy<SrripPolicy>(options.hierarchy_file, args[0], options);
+        case ReplacementPolicy::BRRIP: return simulate_hierarchy<BrripPolicy>(options.hierarchy_file, args[0], options);
+        case ReplacementPolicy::OPT: return simulate_hierarchy<OptPolicy>(options.hierarchy_file, args[0], options);
+        case ReplacementPolicy::LRU:
+        default: return simulate_hierarchy<LruPolicy>(options.hierarchy_file, args[0], options);
+        }
+    }
+    
+    if (args.size() != 8 || !options.hierarchy_file.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <BLOCKSIZE> <L1_SIZE> <L1_ASSOC> <L2_SIZE> <L2_ASSOC> <PREF_N> <PREF_M> <trace_file>" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "Arguments:" << std::endl;
+        std::cerr << "  BLOCKSIZE : Block size in bytes (positive integer)" << std::endl;
+        std::cerr << "  L1_SIZE   : L1 cache size in bytes (positive integer)" << std::endl;
+        std::cerr << "  L1_ASSOC  : L1 set-associativity (positive integer)" << std::endl;
+        std::cerr << "  L2_SIZE   : L2 cache size in bytes (positive integer, 0 = no L2)" << std::endl;
+        std::cerr << "  L2_ASSOC  : L2 set-associativity (positive integer)" << std::endl;
+        std::cerr << "  PREF_N    : Number of Stream Buffers (positive integer, 0 = disabled)" << std::endl;
+        std::cerr << "  PREF_M    : Number of memory blocks per Stream Buffer (positive integer)" << std::endl;
+        std::cerr << "  trace_file: Full name of trace file" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "Options:" << std::endl;
+        std::cerr << "  --verbose        : Echo every decoded trace access" << std::endl;
+        std::cerr << "  --pipeline[=2|3] : Parse on a separate thread (3 = analyzer on a third thread)" << std::endl;
+        std::cerr << "  --threads=N      : Simulate cache sets in N parallel shards" << std::endl;
+        std::cerr << "  --streaming-analysis : Bounded-memory online performance analysis" << std::endl;
+        std::cerr << "  --policy=NAME    : Replacement policy: lru (default), plru, fifo, random, srrip, brrip," << std::endl;
+        std::cerr << "                     opt (Belady bound, L1 only)" << std::endl;
+        std::cerr << "  --cores=N        : Core-tagged trace; private L1 per core, shared L2 (--threads shards it)" << std::endl;
+        std::cerr << "  --split-l1       : With --cores, split each private L1 into L1I and L1D" << std::endl;
+        std::cerr << "  --set-sampling=K : Simulate a random 1/K of the independent set groups" << std::endl;
+        std::cerr << "  --time-sampling=U,W,P : Per P accesses, detailed warmup on W then measure U (rest warmed)" << std::endl;
+        std::cerr << "  --checkpoint-at=N : Save the cache state after N accesses (to --checkpoint-file)" << std::endl;
+        std::cerr << "  --checkpoint-file=FILE : Checkpoint path (default: <trace_file>.ckpt)" << std::endl;
+        std::cerr << "  --restore[=FILE] : Resume from a checkpoint, skipping the accesses it covers" << std::endl;
+        std::cerr << "  --interval=K     : Per-level miss rate, writebacks and dirty blocks every K accesses" << std::endl;
+        std::cerr << "  --interval-file=FILE : Interval CSV path (default: <trace_file>.intervals.csv)" << std::endl;
+        std::cerr << "  --classify-misses : Split each level's misses into compulsory, capacity and conflict" << std::endl;
+        std::cerr << "  --timing         : Cycle-approximate timing with MSHRs, overlapping misses and link bandwidth" << std::endl;
+        std::cerr << "  --mshrs=N[,N...] : MSHRs per level from L1, last value repeats (default: 8)" << std::endl;
+        std::cerr << "  --bus-cycles=N[,N...] : Cycles per block on the link below each level (default: 32 B/cycle on chip, 8 B/cycle to memory)" << std::endl;
+        std::cerr << "  --quiet          : Print only the statistics (no contents dump or analysis report)" << std::endl;
+        std::cerr << "  --format=FMT     : text (default), or one json/csv statistics record (implies --quiet)" << std::endl;
+        std::cerr << "  --trace-cache    : Read the trace through its decoded index <trace_file>.didx (any mode;" << std::endl;
+        std::cerr << "                     built on first use, rebuilt when the trace changes)" << std::endl;
+        std::cerr << "  --address-bits=N : Address width for the area model's tag bits (default 32, any mode)" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "N-level hierarchy from a file (levels, latencies, inclusion policies):" << std::endl;
+        std::cerr << "  " << argv[0] << " --hierarchy=<config_file> [--policy=NAME] [--verbose] [--quiet] [--format=FMT] <trace_file>" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "Sweep mode (many configurations, one trace pass):" << std::endl;
+        std::cerr << "  " << argv[0] << " --sweep <BLOCKSIZE> <L1_SIZES> <L1_ASSOCS> <L2_SIZES> <L2_ASSOCS> <trace_file> [output_csv] [--format=json|csv]" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "Design-space exploration (AAT vs area Pareto front, parallel and pruned):" << std::endl;
+        std::cerr << "  " << argv[0] << " --dse <BLOCKSIZES> <L1_SIZES> <L1_ASSOCS> <L2_SIZES> <L2_ASSOCS> <PREF_NS> <PREF_MS> <trace_file> [output_file]" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "Stack-distance mode (LRU L1-only miss-rate curve, one trace pass):" << std::endl;
+        std::cerr << "  " << argv[0] << " --stack-distance <BLOCKSIZE> <L1_SIZES> <L1_ASSOCS> <trace_file> [output_csv] [--format=json|csv]" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "Convert a text trace to the compact binary format (auto-detected on input):" << std::endl;
+        std::cerr << "  " << argv[0] << " convert <input_trace> <output_binary_trace>" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "Build the decoded index used by --trace-cache and print the trace summary:" << std::endl;
+        std::cerr << "  " << argv[0] << " index <trace_file>" << std::endl;
+        return 1;
+    }
+
+    // Parse command-line arguments
+    int blocksize = std::atoi(args[0].c_str());
+    int l1_size = std::atoi(args[1].c_str());
+    int l1_assoc = std::atoi(args[2].c_str());
+    int l2_size = std::atoi(args[3].c_str());
+    int l2_assoc = std::atoi(args[4].c_str());
+    int pref_n = std::atoi(args[5].c_str());
+    int pref_m = std::atoi(args[6].c_str());
+    std::string trace_file = args[7];
+
+    switch (options.policy) {
+    case ReplacementPolicy::PLRU:
+        return simulate_configuration<PlruPolicy>(blocksize, l1_size, l1_assoc, l2_size, l2_assoc,
+                                                  pref_n, pref_m, trace_file, options);
+    case ReplacementPolicy::FIFO:
+        return simulate_configuration<FifoPolicy>(blocksize, l1_size, l1_assoc, l2_size, l2_assoc,
+                                                  pref_n, pref_m, trace_file, options);
+    case ReplacementPolicy::RANDOM:
+        return simulate_configuration<RandomPolicy>(blocksize, l1_size, l1_assoc, l2_size, l2_assoc,
+                                                    pref_n, pref_m, trace_file, options);
+    case ReplacementPolicy::SRRIP:
+        return simulate_configuration<SrripPolicy>(blocksize, l1_size, l1_assoc, l2_size, l2_assoc,
+                                                   pref_n, pref_m, trace_file, options);
+    case ReplacementPolicy::BRRIP:
+        return simulate_configuration<BrripPolicy>(blocksize, l1_size, l1_assoc, l2_size, l2_assoc,
+                                                   pref_n, pref_m, trace_file, options);
+    case ReplacementPolicy::OPT:
+        return simulate_configuration<OptPolicy>(blocksize, l1_size, l1_assoc, l2_size, l2_assoc,
+                                                 pref_n, pref_m, trace_file, options);
+    case ReplacementPolicy::LRU:
+    default:
+        return simulate_configuration<LruPolicy>(blocksize, l1_size, l1_assoc, l2_size, l2_assoc,
+                                                 pref_n, pref_m, trace_file, options);
+    }
 }
\ No newline at end of file
@@ -18,75 +18,22 @@ echo ""
 
 # Output file for results
 OUTPUT_FILE="enhanced_experiment_results.csv"
-echo "log2_size,size_kb,associativity,miss_rate,aat_cycles,area_mm2,performance_per_area" > $OUTPUT_FILE
 
-# Cache sizes in KB (powers of 2 from 1KB to 1MB)
-SIZES_KB=(1 2 4 8 16 32 64 128 256 512 1024)
+# Cache sizes in bytes (powers of 2 from 1KB to 1MB)
+SIZES=1024,2048,4096,8192,16384,32768,65536,131072,262144,524288,1048576
 
-# Associativities to test
-ASSOCS=(1 2 4 8)
+# Associativities to test ("full" = fully-associative, associativity = number of blocks)
+ASSOCS=1,2,4,8,full
 
 echo "Running experiments..."
-echo "Progress: [Size] x [Associativity]"
-
-for size_kb in "${SIZES_KB[@]}"; do
-    size_bytes=$((size_kb * 1024))
-    
-    # Calculate log2(size_kb) + 10 (since 1KB = 2^10 bytes)
-    case $size_kb in
-        1) log2_size=10 ;;
-        2) log2_size=11 ;;
-        4) log2_size=12 ;;
-        8) log2_size=13 ;;
-        16) log2_size=14 ;;
-        32) log2_size=15 ;;
-        64) log2_size=16 ;;
-        128) log2_size=17 ;;
-        256) log2_size=18 ;;
-        512) log2_size=19 ;;
-        1024) log2_size=20 ;;
-    esac
-    
-    echo ""
-    echo "Testing cache size: ${size_kb}KB (${size_bytes} bytes, log2=${log2_size})"
-    
-    for assoc in "${ASSOCS[@]}"; do
-        echo -n "  Associativity ${assoc}... "
-        
-        # Run cache simulator and capture output
-        ./cache_simulator 32 $size_bytes $assoc 0 0 0 0 gcc_trace.txt > temp_output.txt 2>&1
-        
-        # Extract metrics from output
-        miss_rate=$(grep "e. L1 miss rate:" temp_output.txt | awk '{print $5}')
-        aat_cycles=$(grep "L1 Average Access Time:" temp_output.txt | awk '{print $5}')
-        area_mm2=$(grep "L1 Cache Area:" temp_output.txt | awk '{print $4}')
-        perf_per_area=$(grep "L1 Performance/Area:" temp_output.txt | awk '{print $3}')
-        
-        if [ -n "$miss_rate" ] && [ -n "$aat_cycles" ] && [ -n "$area_mm2" ]; then
-            echo "Miss Rate: $miss_rate, AAT: $aat_cycles cycles, Area: $area_mm2 mm²"
-            echo "$log2_size,$size_kb,$assoc,$miss_rate,$aat_cycles,$area_mm2,$perf_per_area" >> $OUTPUT_FILE
-        else
-            echo "ERROR - Check temp_output.txt"
-        fi
-    done
-    
-    # Test fully-associative (associativity = total number of blocks)
-    num_blocks=$((size_bytes / 32))
-    echo -n "  Fully-associative (${num_blocks}-way)... "
-    
-    ./cache_simulator 32 $size_bytes $num_blocks 0 0 0 0 gcc_trace.txt > temp_output.txt 2>&1
-    miss_rate=$(grep "e. L1 miss rate:" temp_output.txt | awk '{print $5}')
-    aat_cycles=$(grep "L1 Average Access Time:" temp_output.txt | awk '{print $5}')
-    area_mm2=$(grep "L1 Cache Area:" temp_output.txt | awk '{print $4}')
-    perf_per_area=$(grep "L1 Performance/Area:" temp_output.txt | awk '{print $3}')
-    
-    if [ -n "$miss_rate" ] && [ -n "$aat_cycles" ] && [ -n "$area_mm2" ]; then
-        echo "Miss Rate: $miss_rate, AAT: $aat_cycles cycles, Area: $area_mm2 mm²"
-        echo "$log2_size,$size_kb,fully,$miss_rate,$aat_cycles,$area_mm2,$perf_per_area" >> $OUTPUT_FILE
-    else
-        echo "ERROR - Check temp_output.txt"
-    fi
-done
+echo "All [Size] x [Associativity] configurations come from a single stack-distance pass"
+
+# Run cache simulator in stack-distance mode (one CSV row per configuration).
+# LRU inclusion makes this identical to simulating each configuration separately.
+if ! ./cache_simulator --stack-distance 32 $SIZES $ASSOCS gcc_trace.txt $OUTPUT_FILE 2> temp_output.txt; then
+    echo "ERROR - Check temp_output.txt"
+    exit 1
+fi
 
 echo ""
 echo "Enhanced experiment complete! Results saved to: $OUTPUT_FILE"